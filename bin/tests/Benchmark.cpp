@@ -194,5 +194,22 @@ int main()
 
   //––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
 
+  result << "\nNEW: Timing scopes with LOG_SCOPE_TIMER:\n";
+  timer.start();
+  for ( uint32_t i = 0; i < 10000; ++i) {
+    LOG_SCOPE_TIMER(eval, "benchmark loop");
+  }
+  duration = timer.stop();
+  result << "TIMER LOGGING: " << duration << "µs (" << duration*0.001l << "ms)\n";
+
+  timer.start();
+  for ( uint32_t i = 0; i < 10000; ++i) {
+    LOG_SCOPE_TIMER(debug, "benchmark loop");
+  }
+  duration = timer.stop();
+  result << "TIMER CUTOFF:  " << duration << "µs (" << duration*0.001l << "ms)\n";
+
+  //––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
+
   return 0;
 }
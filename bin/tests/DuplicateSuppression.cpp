@@ -0,0 +1,74 @@
+// Logs runs of duplicate messages with {"suppress_duplicates", "200"} into a file and
+// checks the printed lines: summaries are printed before the next different message, an
+// expired window ends the run and a batch interrupts it.
+//
+// Usage: duplicateSuppression <log path>
+
+#include <bragi>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct DuplicateTest{};
+BRAGI_INIT(DuplicateTest, compConfig_duplicatesuppression)
+
+int main(int argc, char* argv[])
+{
+  if (argc != 2)
+  {
+    std::cerr << "usage: " << argv[0] << " <log path>\n";
+    return 1;
+  }
+  bragi::configureLogging(
+      {{"type", "file"}, {"path", argv[1]}, {"suppress_duplicates", "200"}});
+  const auto expireWindow = [] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  };
+
+  // a run ends with the next different message
+  for (int i = 0; i < 5; ++i) LOG_WARN << "run";
+  LOG_INFO << "run";  // same text, different level
+  // an expired window ends the run, the message is printed again
+  LOG_INFO << "expiring";
+  LOG_INFO << "expiring";
+  expireWindow();
+  LOG_INFO << "expiring";
+  // a batch ends the run, the next message is never a duplicate
+  for (int i = 0; i < 3; ++i) LOG_INFO << "batched";
+  {
+    auto batch = LOG_INFO_BATCH;
+    batch.line() << "batch line";
+    batch.line() << "batch line";
+  }
+  LOG_INFO << "batched";
+  LOG_INFO << "end";
+
+  const std::vector<std::string> expected{
+      "[WARN]  [DuplicateTest] run",
+      "[WARN]  last message repeated 4 times",
+      "[INFO]  [DuplicateTest] run",
+      "[INFO]  [DuplicateTest] expiring",
+      "[INFO]  last message repeated 1 time",
+      "[INFO]  [DuplicateTest] expiring",
+      "[INFO]  [DuplicateTest] batched",
+      "[INFO]  last message repeated 2 times",
+      "[INFO]  [DuplicateTest] batch line",
+      "[INFO]  [DuplicateTest] batch line",
+      "[INFO]  [DuplicateTest] batched",
+      "[INFO]  [DuplicateTest] end"};
+
+  std::ifstream log{argv[1]};
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(log, line);) lines.push_back(line);
+  if (lines != expected)
+  {
+    std::cerr << "unexpected log:\n";
+    for (const auto& line : lines) std::cerr << line << '\n';
+    return 1;
+  }
+  std::cout << "duplicates suppressed as expected\n";
+}
@@ -0,0 +1,128 @@
+// Logs into a file with {"shed_latency", "1"}, a threshold every write exceeds, so the
+// writer sheds until it is destroyed. A second run reads the log file, which is only
+// complete after the first program exited, and checks it: shedding is reported when it
+// starts and when the writer is closed, no warning is dropped, the written and the
+// reported dropped info messages add up, and every duplicate summary directly follows
+// the message it counts.
+//
+// Usage: loadShedding record <log path>
+//        loadShedding check <log path>
+
+#include <bragi>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+
+struct ShedTest{};
+BRAGI_INIT(ShedTest, compConfig_loadshedding)
+
+constexpr int infoCount = 5000;
+constexpr int warnInterval = 250;
+constexpr int warnRepetitions = 3;
+
+void record(const std::string& path)
+{
+  bragi::configureLogging({{"type", "file"},
+                           {"path", path},
+                           {"shed_latency", "1"},
+                           {"shed_window", "1"},
+                           {"suppress_duplicates", "1000"}});
+  for (int i = 0; i < infoCount; ++i)
+  {
+    LOG_INFO << "info " << i;
+    if (i % warnInterval != 0) continue;
+    for (int repetition = 0; repetition < warnRepetitions; ++repetition)
+      LOG_WARN << "warn " << i;
+  }
+  // pending duplicates when the writer is destroyed
+  for (int repetition = 0; repetition < warnRepetitions; ++repetition)
+    LOG_WARN << "warn end";
+}
+
+// returns the number in "... <number> messages were dropped" or -1
+long droppedCount(const std::string& line)
+{
+  const auto end = line.rfind(" messages were dropped");
+  if (end == std::string::npos) return -1;
+  const auto begin = line.rfind(' ', end - 1) + 1;
+  return std::stol(line.substr(begin, end - begin));
+}
+
+int check(const std::string& path)
+{
+  const std::string start = "[WARN]  [bragi] output is falling behind";
+  const std::string repeated = "[WARN]  last message repeated ";
+
+  std::ifstream log{path};
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(log, line);)
+    if (line.compare(0, 7, "[DEBUG]") != 0) lines.push_back(line);
+
+  int failures = 0;
+  const auto fail = [&failures](const std::string& what) {
+    if (failures++ < 10) std::cerr << what << '\n';
+  };
+  bool shedding = false;
+  long written = 0;
+  long dropped = 0;
+  std::map<std::string, long> warnings;  // printed and repeated, by message
+  for (std::size_t i = 0; i < lines.size(); ++i)
+  {
+    const auto& line = lines[i];
+    if (line.compare(0, start.size(), start) == 0)
+    {
+      if (shedding) fail("shedding started twice: " + line);
+      shedding = true;
+    }
+    else if (droppedCount(line) >= 0)
+    {
+      if (!shedding) fail("shedding stopped without start: " + line);
+      shedding = false;
+      dropped += droppedCount(line);
+    }
+    else if (line.compare(0, repeated.size(), repeated) == 0)
+    {
+      if (i == 0 || lines[i - 1].compare(0, 17, "[WARN]  [ShedTest") != 0)
+        fail("summary does not follow its message: " + line);
+      else
+        warnings[lines[i - 1]] += std::stol(line.substr(repeated.size()));
+    }
+    else if (line.compare(0, 18, "[INFO]  [ShedTest]") == 0)
+      ++written;
+    else if (line.compare(0, 18, "[WARN]  [ShedTest]") == 0)
+      ++warnings[line];
+    else
+      fail("unexpected line: " + line);
+  }
+
+  if (lines.empty() || droppedCount(lines.back()) < 0 || shedding)
+    fail("the last line does not report the end of shedding");
+  if (written + dropped != infoCount)
+    fail(std::to_string(written) + " info messages written and " +
+         std::to_string(dropped) + " dropped, expected " + std::to_string(infoCount));
+  for (int i = 0; i < infoCount; i += warnInterval)
+    if (warnings["[WARN]  [ShedTest] warn " + std::to_string(i)] != warnRepetitions)
+      fail("warning " + std::to_string(i) + " is missing");
+  if (warnings["[WARN]  [ShedTest] warn end"] != warnRepetitions)
+    fail("the last warning is missing");
+
+  if (failures != 0) return 1;
+  std::cout << written << " info messages written, " << dropped << " dropped\n";
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  const std::string mode = argc == 3 ? argv[1] : "";
+  if (mode == "record")
+  {
+    record(argv[2]);
+    return 0;
+  }
+  if (mode == "check") return check(argv[2]);
+  std::cerr << "usage: " << argv[0] << " record|check <log path>\n";
+  return 1;
+}
@@ -0,0 +1,92 @@
+// Checks the bucket math of ScopeHistogram: every duration lies in the bucket bucketIndex
+// assigns to it, the buckets are ordered and contiguous, and percentile picks the bucket
+// of the requested rank and is capped at the maximum.
+//
+// Usage: scopeHistogram
+
+#include <bragi>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+
+using bragi::ScopeHistogram;
+using Buckets = std::array<uint64_t, ScopeHistogram::bucketCount>;
+
+int failures = 0;
+
+void check(const bool condition, const char* what, const uint64_t value)
+{
+  if (condition) return;
+  std::cerr << what << " failed for " << value << '\n';
+  ++failures;
+}
+
+void checkPercentile(const std::vector<uint64_t>& durations, const double quantile,
+                     const uint64_t expected)
+{
+  Buckets buckets{};
+  uint64_t max = 0;
+  for (const auto ns : durations)
+  {
+    ++buckets[ScopeHistogram::bucketIndex(ns)];
+    if (ns > max) max = ns;
+  }
+  const auto result = ScopeHistogram::percentile(buckets, durations.size(), max, quantile);
+  if (result == expected) return;
+  std::cerr << "percentile " << quantile << " is " << result << ", expected " << expected
+            << '\n';
+  ++failures;
+}
+
+int main()
+{
+  std::vector<uint64_t> durations;
+  for (uint64_t ns = 0; ns < 4096; ++ns) durations.push_back(ns);
+  for (unsigned bit = 12; bit < 64; ++bit)
+  {
+    const auto power = uint64_t{1} << bit;
+    durations.insert(durations.end(), {power - 1, power, power + 1, power + power / 3});
+  }
+  durations.push_back(std::numeric_limits<uint64_t>::max());
+
+  for (const auto ns : durations)
+  {
+    const auto index = ScopeHistogram::bucketIndex(ns);
+    check(index < ScopeHistogram::bucketCount, "index in range", ns);
+    if (index >= ScopeHistogram::bucketCount) continue;
+    const auto lower = ScopeHistogram::bucketLowerBound(index);
+    const auto width = ScopeHistogram::bucketWidth(index);
+    check(lower <= ns && ns - lower < width, "duration within its bucket", ns);
+    // relative error bounded by 1 / subBucketCount
+    check(width == 1 || width * ScopeHistogram::subBucketCount <= lower,
+          "bucket width", ns);
+  }
+
+  // the buckets are contiguous up to the last one in use
+  const auto lastIndex = ScopeHistogram::bucketIndex(std::numeric_limits<uint64_t>::max());
+  for (std::size_t i = 0; i < lastIndex; ++i)
+    check(ScopeHistogram::bucketLowerBound(i) + ScopeHistogram::bucketWidth(i) ==
+              ScopeHistogram::bucketLowerBound(i + 1),
+          "contiguous buckets", i);
+
+  // durations below subBucketCount have buckets of width one, hence exact percentiles
+  checkPercentile({1, 2, 3, 4, 5, 6, 7, 8, 9, 10}, 0.5, 5);
+  checkPercentile({1, 2, 3, 4, 5, 6, 7, 8, 9, 10}, 0.99, 9);
+  checkPercentile({1, 2, 3, 4, 5, 6, 7, 8, 9, 10}, 0.0, 1);
+  checkPercentile({7}, 0.99, 7);
+  // 1000 lies in [992, 1024), the midpoint 1007 is capped at the maximum
+  checkPercentile({1000}, 0.5, 1000);
+  // one outlier among two hundred durations moves neither p50 nor p99
+  std::vector<uint64_t> mostlyFast(199, 3);
+  mostlyFast.push_back(1000000);
+  checkPercentile(mostlyFast, 0.5, 3);
+  checkPercentile(mostlyFast, 0.99, 3);
+  // 1000000 lies in [983040, 1015808), the midpoint is below the maximum
+  checkPercentile(mostlyFast, 1.0, 999423);
+
+  if (failures != 0) return 1;
+  std::cout << "histogram buckets and percentiles as expected\n";
+}
@@ -0,0 +1,106 @@
+// Logs from several threads with the LogWriter type "sharded", merges the shards with
+// bragi_merge and checks the merged log: all lines are present, the lines of every
+// thread keep their order and the lines of a batch are contiguous.
+//
+// Usage: shardedMerge <path of bragi_merge> <log path>
+
+#include <bragi>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct ShardTest{};
+BRAGI_INIT(ShardTest, compConfig_shardedmerge)
+
+constexpr int threadCount = 6;
+constexpr int messageCount = 2000;
+constexpr int batchInterval = 100;
+constexpr int batchLines = 4;
+
+void work(const int thread)
+{
+  for (int i = 0; i < messageCount; ++i)
+  {
+    LOG_INFO << "msg " << thread << ' ' << i;
+    if (i % batchInterval != 0) continue;
+    auto batch = LOG_INFO_BATCH;
+    for (int line = 0; line < batchLines; ++line)
+      batch.line() << "batch " << thread << ' ' << i << ' ' << line;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc != 3)
+  {
+    std::cerr << "usage: " << argv[0] << " <path of bragi_merge> <log path>\n";
+    return 1;
+  }
+  const std::string path = argv[2];
+  bragi::configureLogging({{"type", "sharded"}, {"path", path}});
+
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < threadCount; ++thread) threads.emplace_back(work, thread);
+  for (auto& thread : threads) thread.join();  // the shards are written on thread exit
+
+  const auto merge = '"' + std::string{argv[1]} + "\" \"" + path + "\".* > \"" + path + '"';
+  if (std::system(merge.c_str()) != 0)
+  {
+    std::cerr << "bragi_merge failed: " << merge << '\n';
+    return 1;
+  }
+
+  std::ifstream merged{path};
+  std::vector<int> lastMessage(threadCount, -1);
+  int messages = 0;
+  int batchLinesSeen = 0;
+  int openBatchLine = 0;  // expected next line of the current batch, 0 if none is open
+  std::string line;
+  while (std::getline(merged, line))
+  {
+    std::istringstream fields{line.substr(line.rfind("] ") + 2)};
+    std::string kind;
+    int thread = 0;
+    int index = 0;
+    fields >> kind >> thread >> index;
+    if (kind == "batch")
+    {
+      int batchLine = 0;
+      fields >> batchLine;
+      if (batchLine != openBatchLine)
+      {
+        std::cerr << "batch is not contiguous: " << line << '\n';
+        return 1;
+      }
+      openBatchLine = batchLine + 1 < batchLines ? batchLine + 1 : 0;
+      ++batchLinesSeen;
+    }
+    else if (kind == "msg")
+    {
+      if (openBatchLine != 0 || index <= lastMessage[static_cast<std::size_t>(thread)])
+      {
+        std::cerr << "unexpected line: " << line << '\n';
+        return 1;
+      }
+      lastMessage[static_cast<std::size_t>(thread)] = index;
+      ++messages;
+    }
+  }
+
+  const int expectedBatchLines =
+      threadCount * ((messageCount + batchInterval - 1) / batchInterval) * batchLines;
+  if (messages != threadCount * messageCount || batchLinesSeen != expectedBatchLines)
+  {
+    std::cerr << "merged log has " << messages << " messages and " << batchLinesSeen
+              << " batch lines, expected " << threadCount * messageCount << " and "
+              << expectedBatchLines << '\n';
+    return 1;
+  }
+  std::cout << "merged " << messages << " messages and " << batchLinesSeen
+            << " batch lines\n";
+}
@@ -82,6 +82,12 @@ void work()
                    << "a " << "thread " << "and like " << "to print " << "stuff "
                    << 5 << " gubbl gubbl gubbl " << 65.78f;
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    // the lines of a batch must never be interleaved with lines of other threads
+    auto batch = LOG_WARN_BATCH;
+    for (size_t line = 0; line < 5; ++line)
+      batch.line() << "Thread_ID[" << std::this_thread::get_id() << "] LOG_WARN_BATCH: "
+                   << "line " << line << " of 5";
   }
 }
 
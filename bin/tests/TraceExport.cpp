@@ -0,0 +1,304 @@
+// Records spans and messages with {"trace", "<path>"} from several threads, flushing the
+// trace concurrently. A second run parses the trace file, which is only complete after
+// the first program exited, and checks that it is valid JSON: messages are escaped,
+// every thread is announced before its events, and the begin and end events of every
+// thread are properly nested.
+//
+// Usage: traceExport record <trace path>
+//        traceExport check <trace path>
+
+#include <bragi>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct TraceTest{};
+BRAGI_INIT(TraceTest, compConfig_traceexport)
+
+constexpr int threadCount = 4;
+constexpr int messageCount = 600;  // more than one chunk of events per thread
+const std::string special = "\"quoted\" back\\slash\nnew line\ttab\x01";
+
+void work(const int thread)
+{
+  LOG_SPAN(info, "outer");
+  for (int i = 0; i < messageCount; ++i)
+  {
+    LOG_SPAN(info, "inner");
+    LOG_INFO << special << ' ' << thread << ' ' << i;
+  }
+}
+
+void record(const std::string& path)
+{
+  bragi::configureLogging({{"type", "file"}, {"path", path + ".log"}, {"trace", path}});
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < threadCount; ++thread) threads.emplace_back(work, thread);
+  for (int i = 0; i < 20; ++i) bragi::flushTrace();
+  for (auto& thread : threads) thread.join();
+  LOG_INFO << special;
+}
+
+
+// just enough JSON to read the trace file back
+struct Json
+{
+  enum class Type { null, boolean, number, string, array, object } type = Type::null;
+  double number = 0.0;
+  std::string string;
+  std::vector<Json> elements;
+  std::vector<std::pair<std::string, Json>> members;
+
+  const Json& operator[](const std::string& key) const
+  {
+    static const Json missing;
+    for (const auto& member : members)
+      if (member.first == key) return member.second;
+    return missing;
+  }
+};
+
+class JsonParser
+{
+ public:
+  explicit JsonParser(std::string text) : text_{std::move(text)} {}
+
+  Json parseDocument()
+  {
+    auto value = parse();
+    skipSpace();
+    if (position_ != text_.size()) fail("trailing characters");
+    return value;
+  }
+
+ private:
+  [[noreturn]] void fail(const char* what) const
+  {
+    std::cerr << "invalid JSON at offset " << position_ << ": " << what << '\n';
+    std::exit(1);
+  }
+
+  void skipSpace()
+  {
+    while (position_ < text_.size() &&
+           (text_[position_] == ' ' || text_[position_] == '\n' ||
+            text_[position_] == '\t' || text_[position_] == '\r'))
+      ++position_;
+  }
+
+  char next()
+  {
+    if (position_ == text_.size()) fail("unexpected end");
+    return text_[position_++];
+  }
+
+  void expect(const std::string& literal)
+  {
+    if (text_.compare(position_, literal.size(), literal) != 0)
+      fail("unexpected literal");
+    position_ += literal.size();
+  }
+
+  Json parse()
+  {
+    skipSpace();
+    Json value;
+    if (position_ == text_.size()) fail("unexpected end");
+    switch (text_[position_])
+    {
+      case '{':
+        value.type = Json::Type::object;
+        ++position_;
+        skipSpace();
+        if (text_[position_] == '}') return ++position_, value;
+        while (true)
+        {
+          skipSpace();
+          if (next() != '"') fail("expected a key");
+          auto key = parseString();
+          skipSpace();
+          if (next() != ':') fail("expected ':'");
+          value.members.emplace_back(std::move(key), parse());
+          skipSpace();
+          const auto separator = next();
+          if (separator == '}') return value;
+          if (separator != ',') fail("expected ',' or '}'");
+        }
+      case '[':
+        value.type = Json::Type::array;
+        ++position_;
+        skipSpace();
+        if (text_[position_] == ']') return ++position_, value;
+        while (true)
+        {
+          value.elements.push_back(parse());
+          skipSpace();
+          const auto separator = next();
+          if (separator == ']') return value;
+          if (separator != ',') fail("expected ',' or ']'");
+        }
+      case '"':
+        ++position_;
+        value.type = Json::Type::string;
+        value.string = parseString();
+        return value;
+      case 't': expect("true"); value.type = Json::Type::boolean; return value;
+      case 'f': expect("false"); value.type = Json::Type::boolean; return value;
+      case 'n': expect("null"); return value;
+      default:
+      {
+        const char* begin = text_.c_str() + position_;
+        char* end = nullptr;
+        value.number = std::strtod(begin, &end);
+        if (end == begin) fail("expected a value");
+        position_ += static_cast<std::size_t>(end - begin);
+        value.type = Json::Type::number;
+        return value;
+      }
+    }
+  }
+
+  // only \u escapes below 0x80 are decoded, TraceSink does not write others
+  std::string parseString()
+  {
+    std::string result;
+    while (true)
+    {
+      const auto c = next();
+      if (c == '"') return result;
+      if (static_cast<unsigned char>(c) < 0x20) fail("unescaped control character");
+      if (c != '\\')
+      {
+        result += c;
+        continue;
+      }
+      switch (next())
+      {
+        case '"': result += '"'; break;
+        case '\\': result += '\\'; break;
+        case '/': result += '/'; break;
+        case 'b': result += '\b'; break;
+        case 'f': result += '\f'; break;
+        case 'n': result += '\n'; break;
+        case 'r': result += '\r'; break;
+        case 't': result += '\t'; break;
+        case 'u':
+        {
+          const auto code = std::stoul(text_.substr(position_, 4), nullptr, 16);
+          if (code >= 0x80) fail("unsupported \\u escape");
+          result += static_cast<char>(code);
+          position_ += 4;
+          break;
+        }
+        default: fail("invalid escape");
+      }
+    }
+  }
+
+  const std::string text_;
+  std::size_t position_ = 0;
+};
+
+
+int check(const std::string& path)
+{
+  std::ifstream file{path};
+  const std::string text{std::istreambuf_iterator<char>{file},
+                         std::istreambuf_iterator<char>{}};
+  const auto trace = JsonParser{text}.parseDocument();
+  const auto& events = trace["traceEvents"];
+  if (events.type != Json::Type::array)
+  {
+    std::cerr << "no traceEvents array\n";
+    return 1;
+  }
+
+  int failures = 0;
+  const auto fail = [&failures](const std::string& what) {
+    if (failures++ < 10) std::cerr << what << '\n';
+  };
+  std::map<int, std::vector<std::string>> openSpans;  // by tid, announced threads only
+  std::map<int, double> lastTimestamp;
+  std::map<std::string, int> messages;
+  for (const auto& event : events.elements)
+  {
+    const auto& phase = event["ph"].string;
+    const auto tid = static_cast<int>(event["tid"].number);
+    if (event["pid"].number != 1.0 || event["tid"].type != Json::Type::number)
+      fail("missing pid or tid");
+    if (phase == "M")
+    {
+      if (!openSpans.emplace(tid, std::vector<std::string>{}).second)
+        fail("thread " + std::to_string(tid) + " announced twice");
+      if (event["args"]["name"].string != "thread " + std::to_string(tid))
+        fail("unexpected thread name " + event["args"]["name"].string);
+      continue;
+    }
+
+    auto spans = openSpans.find(tid);
+    if (spans == openSpans.end())
+    {
+      fail("event of unannounced thread " + std::to_string(tid));
+      continue;
+    }
+    if (event["cat"].string != "TraceTest")
+      fail("unexpected category " + event["cat"].string);
+    const auto timestamp = event["ts"].number;
+    if (timestamp < lastTimestamp[tid]) fail("timestamps out of order");
+    lastTimestamp[tid] = timestamp;
+
+    if (phase == "B")
+      spans->second.push_back(event["name"].string);
+    else if (phase == "E")
+    {
+      if (spans->second.empty() || spans->second.back() != event["name"].string)
+        fail("end of span " + event["name"].string + " without matching begin");
+      else
+        spans->second.pop_back();
+    }
+    else if (phase == "i")
+    {
+      ++messages[event["name"].string];
+      if (event["args"]["level"].string != "INFO")
+        fail("unexpected level " + event["args"]["level"].string);
+    }
+    else
+      fail("unexpected phase " + phase);
+  }
+
+  for (const auto& spans : openSpans)
+    if (!spans.second.empty())
+      fail("unfinished span on thread " + std::to_string(spans.first));
+  if (openSpans.size() != threadCount + 1) fail("unexpected number of threads");
+  if (messages["[TraceTest] " + special] != 1) fail("message of the main thread missing");
+  for (int thread = 0; thread < threadCount; ++thread)
+    for (int i = 0; i < messageCount; ++i)
+    {
+      const auto message = "[TraceTest] " + special + ' ' + std::to_string(thread) + ' ' +
+                           std::to_string(i);
+      if (messages[message] != 1) fail("missing or repeated message: " + message);
+    }
+
+  if (failures != 0) return 1;
+  std::cout << events.elements.size() << " trace events as expected\n";
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  const std::string mode = argc == 3 ? argv[1] : "";
+  if (mode == "record")
+  {
+    record(argv[2]);
+    return 0;
+  }
+  if (mode == "check") return check(argv[2]);
+  std::cerr << "usage: " << argv[0] << " record|check <trace path>\n";
+  return 1;
+}
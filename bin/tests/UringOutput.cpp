@@ -0,0 +1,108 @@
+// Logs from several threads with the LogWriter type "uring", with small blocks and
+// warnings between the messages, so blocks are submitted full, partially and with the
+// carried page of O_DIRECT. A second run reads the log file, which is only complete after
+// the first program exited, and compares it line by line: every line is intact, and the
+// lines of every thread are complete and in order.
+//
+// Usage: uringOutput record <log path> [<key>=<value> ...]
+//        uringOutput check <log path>
+
+#include <bragi>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct UringTest{};
+BRAGI_INIT(UringTest, compConfig_uringoutput)
+
+constexpr int threadCount = 4;
+constexpr int messageCount = 3000;
+constexpr int warnInterval = 37;
+
+// padded to varying lengths, so lines cross block and page boundaries
+std::string message(const int thread, const int i)
+{
+  return "msg " + std::to_string(thread) + ' ' + std::to_string(i) + ' ' +
+         std::string(static_cast<std::size_t>(i % 101), 'x');
+}
+
+void work(const int thread)
+{
+  for (int i = 0; i < messageCount; ++i)
+  {
+    if (i % warnInterval == 0)
+      LOG_WARN << message(thread, i);
+    else
+      LOG_INFO << message(thread, i);
+  }
+}
+
+void record(const char* path, const std::vector<std::string>& options)
+{
+  bragi::LoggingConfig config{
+      {"type", "uring"}, {"path", path}, {"block_size", "4096"}, {"blocks", "2"}};
+  for (const auto& option : options)
+  {
+    const auto separator = option.find('=');
+    config[option.substr(0, separator)] =
+        separator != std::string::npos ? option.substr(separator + 1) : "";
+  }
+  bragi::configureLogging(config);
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < threadCount; ++thread) threads.emplace_back(work, thread);
+  for (auto& thread : threads) thread.join();
+}
+
+int check(const char* path)
+{
+  std::ifstream log{path};
+  std::map<int, int> next;  // next message index by thread
+  int failures = 0;
+  int lineNumber = 0;
+  for (std::string line; std::getline(log, line);)
+  {
+    ++lineNumber;
+    // the creation of the writer is reported at debug level, if it is enabled
+    if (line.compare(0, 7, "[DEBUG]") == 0) continue;
+
+    std::istringstream fields{line.substr(line.rfind("] ") + 2)};
+    std::string word;
+    int thread = -1;
+    int i = -1;
+    fields >> word >> thread;
+    if (thread >= 0 && thread < threadCount) i = next[thread]++;
+    const std::string prefix = i % warnInterval == 0 ? "[WARN]  " : "[INFO]  ";
+    if (i >= 0 && line == prefix + "[UringTest] " + message(thread, i)) continue;
+    if (failures++ < 10)
+      std::cerr << "line " << lineNumber << " is unexpected: " << line << '\n';
+  }
+  for (int thread = 0; thread < threadCount; ++thread)
+    if (next[thread] != messageCount)
+    {
+      std::cerr << "thread " << thread << " wrote " << next[thread] << " lines\n";
+      ++failures;
+    }
+
+  if (failures != 0) return 1;
+  std::cout << lineNumber << " lines as expected\n";
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  const std::string mode = argc >= 3 ? argv[1] : "";
+  if (mode == "record")
+  {
+    record(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+    return 0;
+  }
+  if (mode == "check" && argc == 3) return check(argv[2]);
+  std::cerr << "usage: " << argv[0] << " record <log path> [<key>=<value> ...]\n"
+            << "       " << argv[0] << " check <log path>\n";
+  return 1;
+}
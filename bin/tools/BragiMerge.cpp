@@ -0,0 +1,97 @@
+// bragi_merge: merges the shard files written by bragi::ShardedFileLogWriter
+// ({"type", "sharded"}) into one log, ordered by timestamp and sequence number.
+//
+// Usage: bragi_merge <shard>... > <merged log>
+//
+// The shards are merged in a streaming fashion: only the next record of every shard is
+// held in memory, independent of the size of the shards.
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+
+struct Record
+{
+  uint64_t timestamp;
+  uint64_t sequence;
+  std::size_t shard;
+  std::string message;
+};
+
+// orders the priority queue to yield the oldest record first
+struct NewerRecord
+{
+  bool operator()(const Record& lhs, const Record& rhs) const
+  {
+    if (lhs.timestamp != rhs.timestamp) return lhs.timestamp > rhs.timestamp;
+    return lhs.sequence > rhs.sequence;
+  }
+};
+
+
+// reads one record: "<timestamp> <sequence> <size> <message of size bytes>\n"
+bool readRecord(std::istream& shard, Record& record)
+{
+  std::size_t size = 0;
+  if (!(shard >> record.timestamp >> record.sequence >> size) || shard.get() != ' ')
+    return false;
+  record.message.resize(size);
+  if (size != 0 && !shard.read(&record.message[0], static_cast<std::streamsize>(size)))
+    return false;
+  return shard.get() == '\n';
+}
+
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "usage: " << argv[0] << " <shard>... > <merged log>\n";
+    return 1;
+  }
+
+  std::vector<std::unique_ptr<std::ifstream>> shards;
+  std::priority_queue<Record, std::vector<Record>, NewerRecord> next;
+  int result = 0;
+
+  auto readNext = [&](const std::size_t index) {
+    auto& shard = *shards[index];
+    Record record{0, 0, index, {}};
+    if (readRecord(shard, record))
+      next.push(std::move(record));
+    else if (!(shard.eof() && record.message.empty() && record.timestamp == 0))
+    {
+      // e.g. the last record of a shard, whose thread did not exit properly
+      std::cerr << "bragi_merge: skipping the rest of " << argv[index + 1]
+                << ": malformed record\n";
+      result = 1;
+    }
+  };
+
+  for (int i = 1; i < argc; ++i)
+  {
+    shards.emplace_back(new std::ifstream{argv[i], std::ifstream::binary});
+    if (!*shards.back())
+    {
+      std::cerr << "bragi_merge: can not open " << argv[i] << '\n';
+      return 1;
+    }
+    readNext(shards.size() - 1);
+  }
+
+  std::ios_base::sync_with_stdio(false);
+  while (!next.empty())
+  {
+    const auto shard = next.top().shard;
+    std::cout << next.top().message << '\n';
+    next.pop();
+    readNext(shard);
+  }
+  std::cout.flush();
+  return result;
+}
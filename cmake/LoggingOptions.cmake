@@ -73,6 +73,34 @@ endfunction()
 
 
 
+##––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
+## build time selection of the LogWriter
+##––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
+
+# BRAGI_LOG_WRITER selects the type of the LogWriter:
+#   * runtime:        (default) the type is selected at runtime via configureLogging()
+#   * std_cerr, file: the type is fixed at build time. Messages are passed directly to the
+#                     writer, without static initialization guard and virtual call.
+#                     configureLogging() does not change the LogWriter in this case.
+# The build time LogWriter is configured with:
+#   * BRAGI_LOG_WRITER_COLOR:   true, false or auto (default: colored for std_cerr only)
+#   * BRAGI_LOG_WRITER_PATH:    the output file of the type file
+#   * BRAGI_LOG_WRITER_OPTIONS: all other keys of the LogWriter config as a list of
+#                               key=value pairs, e.g. "timer_interval=500;suppress_duplicates="
+# The keys passed to configureLogging() are ignored by the build time LogWriter.
+#
+# NOTE: These options are global for all components. Set them before the first call of
+#       bragi_add_component() or use cmake -D... on the command line.
+set(BRAGI_LOG_WRITER runtime CACHE STRING "runtime, std_cerr or file")
+set(BRAGI_LOG_WRITER_COLOR auto CACHE STRING "colored output for the build time LogWriter")
+set(BRAGI_LOG_WRITER_PATH bragi_LOG.txt CACHE STRING "output file of the build time LogWriter")
+set(BRAGI_LOG_WRITER_OPTIONS "" CACHE STRING
+    "key=value list of further config keys for the build time LogWriter")
+set_property(CACHE BRAGI_LOG_WRITER PROPERTY STRINGS runtime std_cerr file)
+set_property(CACHE BRAGI_LOG_WRITER_COLOR PROPERTY STRINGS auto true false)
+
+
+
 ##––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
 ## module utility functions and variables
 ##––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
@@ -110,7 +138,9 @@ function(generate_temp_file)
       "//   three variables are defined:\n"
       "//   * BRAGI_<upper_case(<component_name>)>_ENABLE\n"
       "//   * BRAGI_<upper_case(<component_name>)>_LEVEL\n"
-      "//   * compConfig_<lower_case(<component_name>)>\n\n"
+      "//   * compConfig_<lower_case(<component_name>)>\n"
+      "// If BRAGI_LOG_WRITER is not \"runtime\" BRAGI_STATIC_LOG_WRITER and\n"
+      "// BRAGI_STATIC_LOG_WRITER_CONFIG are defined as well.\n\n"
       "#ifndef _BRAGI_PRINT_CONFIG_H_\n#define _BRAGI_PRINT_CONFIG_H_\n")
 
   file(WRITE ${_BRAGI_COMPONENT_CONFIG_TEMP} ${component_config_file_preamble})
@@ -129,6 +159,9 @@ function(generate_temp_file)
     file(APPEND ${_BRAGI_COMPONENT_CONFIG_TEMP} ${content})
   endforeach()
 
+  generate_CXX_log_writer(log_writer_content)
+  file(APPEND ${_BRAGI_COMPONENT_CONFIG_TEMP} "${log_writer_content}")
+
   file(APPEND ${_BRAGI_COMPONENT_CONFIG_TEMP} "\n#endif  // _BRAGI_PRINT_CONFIG_H_")
   configure_file(${_BRAGI_COMPONENT_CONFIG_TEMP} ${_BRAGI_COMPONENT_CONFIG_HEADER})
 endfunction()
@@ -151,3 +184,50 @@ function(generate_CXX_log_level component_name return_var)
     message(FATAL_ERROR ${error_msg})
   endif()
 endfunction()
+
+
+# escapes backslashes and double quotes, so value can be placed in a C++ string literal
+function(escape_CXX_string value return_var)
+  string(REPLACE "\\" "\\\\" value "${value}")
+  string(REPLACE "\"" "\\\"" value "${value}")
+  set(${return_var} "${value}" PARENT_SCOPE)
+endfunction()
+
+
+function(generate_CXX_log_writer return_var)
+  if(BRAGI_LOG_WRITER STREQUAL "runtime")
+    set(${return_var} "" PARENT_SCOPE)
+    return()
+  elseif(BRAGI_LOG_WRITER STREQUAL "std_cerr")
+    set(writer_type "bragi::CerrLogWriter")
+  elseif(BRAGI_LOG_WRITER STREQUAL "file")
+    set(writer_type "bragi::FileLogWriter")
+  else()
+    message(FATAL_ERROR "\"BRAGI_LOG_WRITER\"=${BRAGI_LOG_WRITER} is not one of "
+                        "[runtime;std_cerr;file].")
+  endif()
+
+  escape_CXX_string("${BRAGI_LOG_WRITER_PATH}" writer_path)
+  set(writer_config "{{\"type\", \"${BRAGI_LOG_WRITER}\"}, {\"path\", \"${writer_path}\"}")
+  if(BRAGI_LOG_WRITER_COLOR STREQUAL "auto")
+    if(BRAGI_LOG_WRITER STREQUAL "std_cerr")
+      string(APPEND writer_config ", {\"color\", \"\"}")
+    endif()
+  elseif(BRAGI_LOG_WRITER_COLOR)
+    string(APPEND writer_config ", {\"color\", \"\"}")
+  endif()
+  foreach(option IN LISTS BRAGI_LOG_WRITER_OPTIONS)
+    if(NOT option MATCHES "^([A-Za-z_]+)=(.*)$")
+      message(FATAL_ERROR "\"BRAGI_LOG_WRITER_OPTIONS\" contains \"${option}\", which is "
+                          "not of the form key=value.")
+    endif()
+    escape_CXX_string("${CMAKE_MATCH_2}" option_value)
+    string(APPEND writer_config ", {\"${CMAKE_MATCH_1}\", \"${option_value}\"}")
+  endforeach()
+  string(APPEND writer_config "}")
+
+  string(CONCAT content
+    "\n#define BRAGI_STATIC_LOG_WRITER ${writer_type}\n"
+    "#define BRAGI_STATIC_LOG_WRITER_CONFIG ${writer_config}\n")
+  set(${return_var} "${content}" PARENT_SCOPE)
+endfunction()
@@ -15,6 +15,11 @@ struct SomeClass
 
   static void print_something()
   {
+    // the lifetime of this scope is measured, a summary is printed periodically and at exit
+    LOG_SCOPE_TIMER(info, "print_something");
+    // recorded as a span in the trace file, if configured: {"trace", "<path>"}
+    LOG_SPAN(info, "print_something");
+
     auto persistent_log = LOG_ERROR;
     persistent_log << "This is a persistent log object.";
 
@@ -33,6 +38,10 @@ struct SomeClass
 
     persistent_log << "The logged message is printed, once the object is destroyed.";
     LOG_DEV << "For the fancy developer messages, while you are building stuff :)";
+
+    // all lines of a batch are printed together, when the batch is destroyed
+    auto table = LOG_INFO_BATCH;
+    for (int row = 1; row <= 3; ++row) table.line() << "row " << row << ": " << row * row;
   }
 };
 
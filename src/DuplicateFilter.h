@@ -0,0 +1,115 @@
+/**
+ * @file DuplicateFilter.h
+ * @brief Implements DuplicateFilter, the suppression of repeated messages in LogWriter
+ */
+
+#ifndef _BRAGI_DUPLICATE_FILTER_H_
+#define _BRAGI_DUPLICATE_FILTER_H_
+
+#include <chrono>      // suppression window
+#include <cstdint>
+#include <functional>  // std::hash
+#include <string>
+
+#include "LoggingTypes.h"
+
+namespace bragi {
+
+/**
+ * @brief Drops messages, which are identical (same level, same text) to the message
+ * printed directly before, as long as they arrive within the configured time window.
+ *
+ * Enabled with {"suppress_duplicates", "<window in ms>"} passed to configureLogging(), an
+ * empty value selects DEFAULT_DUPLICATE_WINDOW_MS. Messages are compared by a single hash
+ * of the message and its size and level; the text is not stored.
+ *
+ * When the run of duplicates ends, the window expires or the writer is destroyed, a
+ * summary "last message repeated N times" is printed with the level of the message. The
+ * expiry is only noticed with the next message, there is no timer.
+ *
+ * A DuplicateFilter is not threadsafe, it is used while holding LogWriter::logMutex_. The
+ * hash of a message is computed by fingerprint() before the lock is taken.
+ */
+class DuplicateFilter
+{
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit DuplicateFilter(const std::chrono::milliseconds window) : window_{window} {}
+
+  static inline std::chrono::milliseconds parseWindow(const LoggingConfig& config)
+  {
+    if (config.find("suppress_duplicates") == config.end())
+      return std::chrono::milliseconds{0};
+    return std::chrono::milliseconds{
+        parseNumber(config, "suppress_duplicates", DEFAULT_DUPLICATE_WINDOW_MS)};
+  }
+
+  inline bool enabled() const noexcept { return window_.count() != 0; }
+
+  // @brief hash of message for pass(), 0 if the filter is disabled. It is threadsafe.
+  inline std::size_t fingerprint(const std::string& message) const
+  {
+    return enabled() ? std::hash<std::string>{}(message) : 0;
+  }
+
+  // @brief decides if message is printed (true) or dropped as a duplicate (false).
+  // @param hash   fingerprint(message)
+  // @param writer provides printSummary(const std::string& line, LogLevel level), which
+  //        prints the summary of the suppressed duplicates, before message is printed.
+  template <class Writer>
+  inline bool pass(const std::string& message, const std::size_t hash,
+                   const LogLevel level, Writer& writer)
+  {
+    if (!enabled()) return true;
+
+    const auto now = Clock::now();
+    if (hasLast_ && hash == lastHash_ && message.size() == lastSize_ && level == lastLevel_)
+    {
+      if (now - runStart_ < window_)
+      {
+        ++repeated_;
+        return false;
+      }
+    }
+
+    flush(writer);
+    hasLast_ = true;
+    lastHash_ = hash;
+    lastSize_ = message.size();
+    lastLevel_ = level;
+    runStart_ = now;
+    return true;
+  }
+
+  // prints the summary of pending duplicates, the next message is never a duplicate.
+  // Used before batches and when the writer is destroyed.
+  template <class Writer>
+  inline void interrupt(Writer& writer)
+  {
+    flush(writer);
+    hasLast_ = false;
+  }
+
+ private:
+  template <class Writer>
+  inline void flush(Writer& writer)
+  {
+    if (repeated_ == 0) return;
+    writer.printSummary("last message repeated " + std::to_string(repeated_) +
+                            (repeated_ == 1 ? " time" : " times"),
+                        lastLevel_);
+    repeated_ = 0;
+  }
+
+  const std::chrono::milliseconds window_;
+  bool hasLast_ = false;
+  std::size_t lastHash_ = 0;
+  std::size_t lastSize_ = 0;
+  LogLevel lastLevel_ = LogLevel::info;
+  Clock::time_point runStart_{};
+  uint64_t repeated_ = 0;
+};
+
+}  // namespace bragi
+#endif  // _BRAGI_DUPLICATE_FILTER_H_
@@ -0,0 +1,208 @@
+/**
+ * @file LoadShedder.h
+ * @brief Implements LoadShedder, the adaptive cutoff of LogWriter for slow sinks
+ */
+
+#ifndef _BRAGI_LOAD_SHEDDER_H_
+#define _BRAGI_LOAD_SHEDDER_H_
+
+#include <atomic>   // cutoff and backlog are read without holding LogWriter::logMutex_
+#include <chrono>   // write latency
+#include <cstdint>
+#include <sstream>  // formatting of the notices
+#include <string>
+
+#include "LoggingTypes.h"
+
+namespace bragi {
+
+/**
+ * @brief Raises the effective cutoff level of a LogWriter temporarily, while its sink
+ * falls behind.
+ *
+ * The LogWriter reports the latency of every write (including the time spent waiting for
+ * LogWriter::logMutex_) and the backlog (threads waiting for or holding the lock). Both
+ * are tracked as exponential moving averages. If one of them crosses its threshold,
+ * messages below info are dropped. If the sink is still too slow after the next window,
+ * info messages are dropped as well. A step is skipped, if no message it would drop was
+ * written since the last change (e.g. trace, debug and eval are compiled out). Warnings,
+ * errors, dev and higher custom levels are never dropped. Once both averages are below
+ * half of their thresholds, the configured cutoff is restored step by step. A one-line
+ * warning is printed when shedding starts, and when it stops or the writer is destroyed
+ * while shedding, the latter with the number of dropped messages.
+ *
+ * Configuration passed to configureLogging(), shedding is enabled by any threshold:
+ *   {"shed_latency", "<µs>"}   threshold for the average write latency
+ *   {"shed_backlog", "<n>"}    threshold for the average number of waiting threads
+ *   {"shed_window", "<ms>"}    minimum time between two changes of the cutoff
+ *                              (default: DEFAULT_SHED_WINDOW_MS)
+ *
+ * While shedding, one otherwise dropped message per window is written as a probe, so the
+ * recovery of the sink is noticed even if only low level messages are logged.
+ */
+class LoadShedder
+{
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit LoadShedder(const LoggingConfig& config)
+      : latencyThreshold_{static_cast<double>(parseNumber(config, "shed_latency", 0)) *
+                          1000.0}
+      , backlogThreshold_{static_cast<double>(parseNumber(config, "shed_backlog", 0))}
+      , enabled_{latencyThreshold_ > 0.0 || backlogThreshold_ > 0.0}
+      , window_{parseNumber(config, "shed_window", DEFAULT_SHED_WINDOW_MS)}
+  {}
+
+  // @brief decides, before the lock is taken, whether a message with level is dropped.
+  inline bool shed(const LogLevel level) noexcept
+  {
+    if (static_cast<int>(level) >= cutoff_.load(std::memory_order_relaxed)) return false;
+
+    const auto now = Clock::now().time_since_epoch().count();
+    auto nextProbe = nextProbe_.load(std::memory_order_relaxed);
+    if (now >= nextProbe &&
+        nextProbe_.compare_exchange_strong(
+            nextProbe, now + std::chrono::duration_cast<Clock::duration>(window_).count(),
+            std::memory_order_relaxed))
+      return false;
+
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // @brief called before the lock is taken, returns the arrival time for depart()
+  inline Clock::time_point arrive() noexcept
+  {
+    if (!enabled_) return {};
+    backlog_.fetch_add(1, std::memory_order_relaxed);
+    return Clock::now();
+  }
+
+  // @brief called while holding the lock, after the write. Updates the averages and the
+  //        effective cutoff.
+  // @param level  of the written message
+  // @param writer provides printSummary(const std::string& line, LogLevel level), which
+  //        prints the notices about changes of the effective cutoff, and duplicates_.
+  template <class Writer>
+  inline void depart(const Clock::time_point arrival, const LogLevel level,
+                     Writer& writer)
+  {
+    if (!enabled_) return;
+    if (static_cast<int>(level) < lowestWritten_)
+      lowestWritten_ = static_cast<int>(level);
+    const auto now = Clock::now();
+    const auto backlog = backlog_.fetch_sub(1, std::memory_order_relaxed);
+    const auto latency =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - arrival).count();
+    latencyAverage_ += (static_cast<double>(latency) - latencyAverage_) * smoothing;
+    backlogAverage_ += (static_cast<double>(backlog) - backlogAverage_) * smoothing;
+    nextProbe_.store((now + window_).time_since_epoch().count(),
+                     std::memory_order_relaxed);
+
+    if (now - lastChange_ < window_) return;
+    if (overloaded())
+    {
+      // the first further stage, which drops any of the messages actually written
+      for (auto stage = stage_ + 1; stage <= maxStage; ++stage)
+        if (lowestWritten_ < static_cast<int>(stageCutoff(stage)))
+        {
+          changeStage(stage, now, writer);
+          break;
+        }
+    }
+    else if (recovered() && stage_ > 0)
+      changeStage(stage_ - 1, now, writer);
+  }
+
+  // @brief called while holding the lock, when the writer is destroyed. Reports the
+  //        number of dropped messages, if shedding did not stop before.
+  template <class Writer>
+  inline void finish(Writer& writer)
+  {
+    if (stage_ == 0) return;
+    const auto dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    writer.duplicates_.interrupt(writer);
+    writer.printSummary("[bragi] output closed while falling behind: " +
+                            std::to_string(dropped) + " messages were dropped",
+                        LogLevel::warn);
+  }
+
+ private:
+  static constexpr double smoothing = 0.125;  // weight of a new sample in the averages
+  static constexpr unsigned maxStage = 2;
+  static constexpr int noneWritten = 256;  // above every LogLevel
+
+  inline bool overloaded() const noexcept
+  {
+    return (latencyThreshold_ > 0.0 && latencyAverage_ > latencyThreshold_) ||
+           (backlogThreshold_ > 0.0 && backlogAverage_ > backlogThreshold_);
+  }
+
+  inline bool recovered() const noexcept
+  {
+    // the backlog always contains the writing thread itself
+    return (latencyThreshold_ == 0.0 || latencyAverage_ < latencyThreshold_ * 0.5) &&
+           (backlogThreshold_ == 0.0 || backlogAverage_ < backlogThreshold_ * 0.5 + 1.0);
+  }
+
+  // stage 0: no messages are dropped, 1: below info, 2: below warn
+  static inline LogLevel stageCutoff(const unsigned stage) noexcept
+  {
+    return stage == 1 ? LogLevel::info : LogLevel::warn;
+  }
+
+  static inline std::string levelName(const LogLevel level)
+  {
+    const auto& prefix = uncoloredPrefixes.find(level)->second;
+    return prefix.substr(0, prefix.find(']') + 1);
+  }
+
+  // only the start and the end of shedding are reported, not the steps in between. A
+  // pending duplicate summary is printed first, it belongs to the message before.
+  template <class Writer>
+  inline void changeStage(const unsigned stage, const Clock::time_point now,
+                          Writer& writer)
+  {
+    const auto previous = stage_;
+    stage_ = stage;
+    lastChange_ = now;
+    lowestWritten_ = noneWritten;
+    cutoff_.store(stage == 0 ? 0 : static_cast<int>(stageCutoff(stage)),
+                  std::memory_order_relaxed);
+
+    std::ostringstream notice;
+    notice.precision(3);
+    if (previous == 0)
+      notice << "[bragi] output is falling behind (average write latency "
+             << latencyAverage_ * 1e-3 << "µs, backlog " << backlogAverage_
+             << "): dropping messages below " << levelName(stageCutoff(stage));
+    else if (stage == 0)
+      notice << "[bragi] output recovered: "
+             << dropped_.exchange(0, std::memory_order_relaxed)
+             << " messages were dropped";
+    else
+      return;
+    writer.duplicates_.interrupt(writer);
+    writer.printSummary(notice.str(), LogLevel::warn);
+  }
+
+  const double latencyThreshold_;  // in ns, 0 = no threshold
+  const double backlogThreshold_;  // 0 = no threshold
+  const bool enabled_;
+  const std::chrono::milliseconds window_;
+
+  std::atomic<int> cutoff_{0};  // messages below are dropped, 0 = drop nothing
+  std::atomic<unsigned> backlog_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<Clock::rep> nextProbe_{0};
+
+  // guarded by LogWriter::logMutex_
+  double latencyAverage_ = 0.0;
+  double backlogAverage_ = 0.0;
+  unsigned stage_ = 0;
+  Clock::time_point lastChange_{};
+  int lowestWritten_ = noneWritten;  // lowest level written since lastChange_
+};
+
+}  // namespace bragi
+#endif  // _BRAGI_LOAD_SHEDDER_H_
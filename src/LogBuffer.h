@@ -12,8 +12,10 @@
 #include <boost/core/demangle.hpp>  // demabglig of typeinfo (For other implementation: https://stackoverflow.com/questions/281818/unmangling-the-result-of-stdtype-infoname)
 #include <sstream>                  // Logger::logBuffer_
 #include <typeinfo>                 // message prefixes from calling class
+#include <vector>                   // LogBatch::lines_
 
 #include "LoggingTypes.h"
+#include "TraceSink.h"
 
 namespace bragi {
 
@@ -61,7 +63,13 @@ class LogBuffer
   }
 
   // The logged message is printed, when LogBuffer ist destroyed:
-  ~LogBuffer() { getLogWriter().log(buffer_.str(), logLevel); }
+  ~LogBuffer()
+  {
+    if (auto* traceSink = activeTraceSink())
+      traceSink->record('i', logLevel, TraceSink::category<sourceClass>(), nullptr,
+                        buffer_.str());
+    LogWriterPolicy::log(buffer_.str(), logLevel);
+  }
 
   template <typename msgType>
   constexpr LogBuffer<logLevel, sourceClass>& operator<<(msgType&& message)
@@ -75,5 +83,99 @@ class LogBuffer
   std::ostringstream buffer_;
 };
 
+
+
+/**
+ * @brief Collects multiple lines, which are printed together when the batch is destroyed.
+ *
+ * Every line is prefixed just like a single message. All lines are handed to the
+ * LogWriter at once, which prints them with a single locked write: lines logged by other
+ * threads can not interleave with the batch. Use it via the LOG_<LEVEL>_BATCH macros:
+ *   auto batch = LOG_INFO_BATCH;
+ *   batch.line() << "first line";
+ *   batch.line() << "second line " << 2;
+ */
+template <LogLevel logLevel, class sourceClass>
+class LogBatch
+{
+ public:
+  LogBatch() = default;
+  LogBatch(LogBatch&& other)
+      : lines_{std::move(other.lines_)}
+      , line_{std::move(other.line_)}
+      , lineOpen_{other.lineOpen_}
+  {
+    other.lines_.clear();
+    other.lineOpen_ = false;
+  }
+
+  LogBatch(const LogBatch& other) = delete;
+  LogBatch operator=(LogBatch&& other) = delete;
+  LogBatch operator=(const LogBatch& other) = delete;
+
+  // The collected lines are printed, when LogBatch is destroyed:
+  ~LogBatch()
+  {
+    closeLine();
+    if (lines_.empty()) return;
+    if (auto* traceSink = activeTraceSink())
+      for (const auto& line : lines_)
+        traceSink->record('i', logLevel, TraceSink::category<sourceClass>(), nullptr, line);
+    LogWriterPolicy::logBatch(std::move(lines_), logLevel);
+  }
+
+  // starts a new line, following calls of operator<< append to it
+  inline LogBatch<logLevel, sourceClass>& line()
+  {
+    closeLine();
+    if (typeid(sourceClass) != typeid(NO_SOURCE_DEFINED))
+      line_ << '[' << boost::core::demangle(typeid(sourceClass).name()) << "] ";
+    lineOpen_ = true;
+    return *this;
+  }
+
+  template <typename msgType>
+  inline LogBatch<logLevel, sourceClass>& operator<<(msgType&& message)
+  {
+    if (!lineOpen_) line();
+    line_ << std::forward<msgType>(message);
+    return *this;
+  }
+
+ private:
+  inline void closeLine()
+  {
+    if (!lineOpen_) return;
+    lines_.push_back(line_.str());
+    line_.str("");
+    lineOpen_ = false;
+  }
+
+  std::vector<std::string> lines_;
+  std::ostringstream line_;
+  bool lineOpen_ = false;
+};
+
+
+class EmptyLogBatch
+{
+ public:
+  constexpr EmptyLogBatch() noexcept {}
+  constexpr EmptyLogBatch(EmptyLogBatch&&) noexcept {}
+  ~EmptyLogBatch() {}  // user provided, see EmptyScopeTimer
+
+  EmptyLogBatch(const EmptyLogBatch& other) = delete;
+  EmptyLogBatch operator=(EmptyLogBatch&& other) = delete;
+  EmptyLogBatch operator=(const EmptyLogBatch& other) = delete;
+
+  constexpr EmptyLogBatch& line() noexcept { return *this; }
+
+  template <typename T>
+  constexpr EmptyLogBatch& operator<<(T&&) noexcept
+  {
+    return *this;
+  }
+};
+
 }  // namespace bragi
 #endif  // _BRAGI_LOG_BUFFER_H_
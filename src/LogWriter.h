@@ -9,10 +9,17 @@
 #ifndef _LOGGING_TCC_
 #define _LOGGING_TCC_
 
+#include <chrono>    // LogWriter::scopeTimerInterval_
 #include <fstream>   // FileLogWriter
 #include <iostream>  // CerrLogWriter
 #include <memory>    // static LogWriter object
 #include <mutex>     // ensure threadsafety in LogWriter
+#include <new>       // placement new of the StaticWriterPolicy writer
+#include <type_traits>
+#include <vector>    // LogWriter::logBatch
+
+#include "DuplicateFilter.h"
+#include "LoadShedder.h"
 
 
 //––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
@@ -20,6 +27,11 @@
 //––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
 namespace bragi {
 
+class ScopeTimerRegistry;
+class RuntimeWriterPolicy;
+template <class Writer>
+class StaticWriterPolicy;
+
 class LogWriter
 {
  public:
@@ -33,24 +45,72 @@ class LogWriter
   explicit LogWriter(const LoggingConfig& config)
       : logPrefixes_{config.find("color") != config.end() ? coloredPrefixes
                                                           : uncoloredPrefixes}
+      , scopeTimerInterval_{
+            parseNumber(config, "timer_interval", DEFAULT_SCOPE_TIMER_INTERVAL_MS)}
+      , duplicates_{DuplicateFilter::parseWindow(config)}
+      , loadShedder_{config}
   {}
 
  protected:
   virtual inline void log(const std::string&&, const LogLevel) {}
+  // prints all messages (one line each) with a single locked write
+  virtual inline void logBatch(const std::vector<std::string>&&, const LogLevel) {}
+
+  // returns the log level prefix for level, as printed in front of every message
+  inline std::string prefix(const LogLevel level) const
+  {
+    const auto prefixSearch = logPrefixes_.find(level);
+    if (prefixSearch != logPrefixes_.end()) return prefixSearch->second;
+    if (logPrefixes_ == coloredPrefixes)
+      return "\x1b[35;1m[CUSTOM:\x1b[0m\x1b[35;1m" +
+             std::to_string(static_cast<uint8_t>(level)) + "]\x1b[0m ";
+    return "[CUSTOM:" + std::to_string(static_cast<uint8_t>(level)) + "] ";
+  }
+
+  // joins messages to a single block, each line starts with the prefix for level
+  inline std::string joinLines(const std::vector<std::string>& messages,
+                               const LogLevel level) const
+  {
+    const auto linePrefix = prefix(level);
+    std::size_t size = 0;
+    for (const auto& message : messages) size += linePrefix.size() + message.size() + 1;
+    std::string block;
+    block.reserve(size);
+    for (const auto& message : messages)
+    {
+      block += linePrefix;
+      block += message;
+      block += '\n';
+    }
+    return block;
+  }
 
   std::mutex logMutex_;
   const std::unordered_map<LogLevel, std::string, EnumHasher> logPrefixes_;
+  const std::chrono::milliseconds scopeTimerInterval_;  // report interval of ScopeTimers
+  DuplicateFilter duplicates_;  // guarded by logMutex_
+  LoadShedder loadShedder_;     // drops low level messages while the sink falls behind
 
+ private:
   template <LogLevel logLevel, class sourceClass>
   friend class LogBuffer;
+  friend class ScopeTimerRegistry;
+  friend class RuntimeWriterPolicy;
+  template <class Writer>
+  friend class StaticWriterPolicy;
   friend inline std::unique_ptr<LogWriter> createLogWriter(const LoggingConfig& config);
 };
 
 
-class CerrLogWriter : public LogWriter
+class CerrLogWriter final : public LogWriter
 {
  public:
-  ~CerrLogWriter() = default;
+  ~CerrLogWriter()
+  {
+    std::lock_guard<std::mutex> lock(logMutex_);
+    duplicates_.interrupt(*this);
+    loadShedder_.finish(*this);
+  }
 
  private:
   CerrLogWriter() = delete;
@@ -61,10 +121,23 @@ class CerrLogWriter : public LogWriter
 
   explicit CerrLogWriter(const LoggingConfig& config) : LogWriter{config} {}
 
+  inline void printSummary(const std::string& summary, const LogLevel level)
+  {
+    std::cerr << prefix(level) << summary << '\n';
+  }
+
   inline void log(const std::string&& message, const LogLevel level) override
   {
+    if (loadShedder_.shed(level)) return;
+    const auto hash = duplicates_.fingerprint(message);
+    const auto arrival = loadShedder_.arrive();
     std::lock_guard<std::mutex> lock(logMutex_);
+    if (duplicates_.pass(message, hash, level, *this)) print(message, level);
+    loadShedder_.depart(arrival, level, *this);
+  }
 
+  inline void print(const std::string& message, const LogLevel level)
+  {
     const auto prefixSearch = logPrefixes_.find(level);
     if (prefixSearch != logPrefixes_.end())
     {
@@ -82,13 +155,29 @@ class CerrLogWriter : public LogWriter
     }
   }
 
+  inline void logBatch(const std::vector<std::string>&& messages,
+                       const LogLevel level) override
+  {
+    if (loadShedder_.shed(level)) return;
+    const auto block = joinLines(messages, level);
+    const auto arrival = loadShedder_.arrive();
+    std::lock_guard<std::mutex> lock(logMutex_);
+    duplicates_.interrupt(*this);
+    std::cerr << block;
+    loadShedder_.depart(arrival, level, *this);
+  }
+
   template <LogLevel logLevel, class sourceClass>
   friend class LogBuffer;
+  template <class Writer>
+  friend class StaticWriterPolicy;
+  friend class DuplicateFilter;
+  friend class LoadShedder;
   friend inline std::unique_ptr<LogWriter> createLogWriter(const LoggingConfig& config);
 };
 
 
-class FileLogWriter : public LogWriter
+class FileLogWriter final : public LogWriter
 {
  public:
   explicit FileLogWriter(const LoggingConfig& config)
@@ -100,7 +189,13 @@ class FileLogWriter : public LogWriter
   {
     file_.open(fileName_, std::ofstream::out | std::ofstream::trunc);
   }
-  ~FileLogWriter() { file_.close(); }
+  ~FileLogWriter()
+  {
+    std::lock_guard<std::mutex> lock(logMutex_);
+    duplicates_.interrupt(*this);
+    loadShedder_.finish(*this);
+    file_.close();
+  }
 
   FileLogWriter() = delete;
   FileLogWriter(const FileLogWriter& other) = delete;
@@ -111,8 +206,30 @@ class FileLogWriter : public LogWriter
 
   inline void log(const std::string&& message, const LogLevel level) override
   {
+    if (loadShedder_.shed(level)) return;
+    const auto hash = duplicates_.fingerprint(message);
+    const auto arrival = loadShedder_.arrive();
+    std::lock_guard<std::mutex> lock(logMutex_);
+    if (duplicates_.pass(message, hash, level, *this)) print(message, level);
+    loadShedder_.depart(arrival, level, *this);
+  }
+
+  inline void logBatch(const std::vector<std::string>&& messages,
+                       const LogLevel level) override
+  {
+    if (loadShedder_.shed(level)) return;
+    const auto block = joinLines(messages, level);
+    const auto arrival = loadShedder_.arrive();
     std::lock_guard<std::mutex> lock(logMutex_);
+    duplicates_.interrupt(*this);
+    file_ << block;
+    file_.flush();
+    loadShedder_.depart(arrival, level, *this);
+  }
 
+ private:
+  inline void print(const std::string& message, const LogLevel level)
+  {
     const auto prefixSearch = logPrefixes_.find(level);
     if (prefixSearch != logPrefixes_.end())
       file_ << prefixSearch->second << message << '\n';
@@ -122,13 +239,26 @@ class FileLogWriter : public LogWriter
     file_.flush();
   }
 
- private:
+  inline void printSummary(const std::string& summary, const LogLevel level)
+  {
+    file_ << prefix(level) << summary << '\n';
+  }
+  friend class DuplicateFilter;
+  friend class LoadShedder;
+
   const char* fileName_;
   std::ofstream file_;
 };
 
 
 
+}  // namespace bragi
+
+#include "ShardedFileLogWriter.h"  // requires LogWriter
+#include "UringLogWriter.h"        // requires LogWriter, defines BRAGI_HAS_IO_URING
+
+namespace bragi {
+
 //––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
 // get at the static LogWriter object
 //––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
@@ -173,6 +303,38 @@ inline std::unique_ptr<LogWriter> createLogWriter(const LoggingConfig& config)
     }
     return fileLogWriter;
   }
+  else if (type->second == "sharded")
+  {
+    auto shardedLogWriter = std::make_unique<ShardedFileLogWriter>(config);
+    if (BRAGI_GLOBAL_LEVEL <= LogLevel::debug)
+    {
+      shardedLogWriter->log(std::move(creationInfo), LogLevel::debug);
+    }
+    return shardedLogWriter;
+  }
+  else if (type->second == "uring")
+  {
+#ifdef BRAGI_HAS_IO_URING
+    std::unique_ptr<UringLogWriter> uringLogWriter(new UringLogWriter{config});
+    if (uringLogWriter->isValid())
+    {
+      if (BRAGI_GLOBAL_LEVEL <= LogLevel::debug)
+      {
+        uringLogWriter->log(std::move(creationInfo), LogLevel::debug);
+      }
+      return uringLogWriter;
+    }
+#endif
+    // io_uring is not available on this system or kernel: fall back to the file writer
+    auto fileLogWriter = std::make_unique<FileLogWriter>(config);
+    if (BRAGI_GLOBAL_LEVEL <= LogLevel::warn)
+    {
+      fileLogWriter->log("[configureLogging] io_uring is unavailable, falling back to "
+                         "the type \"file\"",
+                         LogLevel::warn);
+    }
+    return fileLogWriter;
+  }
   else
   {
     printConfigError();
@@ -192,5 +354,85 @@ inline LogWriter& getLogWriter(const LoggingConfig& config = {{"type", "std_cerr
 }
 
 
+//––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
+// LogWriter selection: at runtime (default) or at build time
+//––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
+
+// The LogWriter is selected via configureLogging() and reached through getLogWriter().
+class RuntimeWriterPolicy
+{
+ public:
+  static inline LogWriter& get() { return getLogWriter(); }
+  static inline void configure(const LoggingConfig& config) { getLogWriter(config); }
+  static inline void log(const std::string&& message, const LogLevel level)
+  {
+    getLogWriter().log(std::move(message), level);
+  }
+  static inline void logBatch(const std::vector<std::string>&& messages,
+                              const LogLevel level)
+  {
+    getLogWriter().logBatch(std::move(messages), level);
+  }
+};
+
+
+/**
+ * @brief The LogWriter type is selected at build time (CMake option BRAGI_LOG_WRITER).
+ *
+ * The writer lives in constant-initialized static storage and is constructed by a
+ * Schwarz counter (just like std::cerr), before the dynamic initialization of any
+ * translation unit including bragi. Hence every call is a direct, inlinable call to
+ * Writer::log, without a static initialization guard and without a virtual call.
+ * configureLogging() can not change the writer in this mode.
+ */
+template <class Writer>
+class StaticWriterPolicy
+{
+ public:
+  static inline Writer& get() noexcept { return *reinterpret_cast<Writer*>(&storage_); }
+  static inline void configure(const LoggingConfig&) noexcept {}
+  static inline void log(const std::string&& message, const LogLevel level)
+  {
+    get().Writer::log(std::move(message), level);
+  }
+  static inline void logBatch(const std::vector<std::string>&& messages,
+                              const LogLevel level)
+  {
+    get().Writer::logBatch(std::move(messages), level);
+  }
+
+  struct Initializer
+  {
+    explicit Initializer(const LoggingConfig& config)
+    {
+      if (users_++ == 0) new (&storage_) Writer{config};
+    }
+    ~Initializer()
+    {
+      if (--users_ == 0) get().~Writer();
+    }
+  };
+
+ private:
+  static typename std::aligned_storage<sizeof(Writer), alignof(Writer)>::type storage_;
+  static unsigned users_;
+};
+
+template <class Writer>
+typename std::aligned_storage<sizeof(Writer), alignof(Writer)>::type
+    StaticWriterPolicy<Writer>::storage_;
+template <class Writer>
+unsigned StaticWriterPolicy<Writer>::users_ = 0;
+
+
+#if defined(BRAGI_STATIC_LOG_WRITER)
+using LogWriterPolicy = StaticWriterPolicy<BRAGI_STATIC_LOG_WRITER>;
+static const LogWriterPolicy::Initializer staticLogWriterInitializer{
+    LoggingConfig BRAGI_STATIC_LOG_WRITER_CONFIG};
+#else
+using LogWriterPolicy = RuntimeWriterPolicy;
+#endif
+
+
 }  // namespace bragi
 #endif
@@ -17,6 +17,8 @@
  *    to the LogWriter singleton object.
  * 7. By configuring the LogWriter instance (via configureLogging()) the destination
  *    (file or console) and style (colored or uncolored) can be selected.
+ * 8. If tracing is configured, the LogBuffer destructor additionally records the message
+ *    as an instant event with the TraceSink singleton object.
  *
  * @version 2.0.0
  * @date 28th May 2021
@@ -50,6 +52,7 @@ static_assert(std::is_same<decltype(BRAGI_GLOBAL_ENABLE), bool>::value,
 // clang-format off
 #include "LogWriter.h"
 #include "LogBuffer.h"
+#include "ScopeTimer.h"
 // clang-format on
 
 //––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––
@@ -104,6 +107,21 @@ class Logger
   // O3 for not printed messages
   typename std::conditional<isPrinted(), LogBuffer<msgLevel, sourceClass>,
                             EmptyLogBuffer>::type logBuffer_;
+
+ public:
+  // The RAII timer used by LOG_SCOPE_TIMER. Just like logBuffer_ it is an empty type, that
+  // is optimized away completely, if messages of this level are not printed.
+  using ScopeTimerType =
+      typename std::conditional<isPrinted(), bragi::ScopeTimer<msgLevel, sourceClass>,
+                                EmptyScopeTimer>::type;
+  // The batch created by LOG_<LEVEL>_BATCH, empty if messages of this level are not printed.
+  using LogBatchType =
+      typename std::conditional<isPrinted(), LogBatch<msgLevel, sourceClass>,
+                                EmptyLogBatch>::type;
+  // The RAII span used by LOG_SPAN, empty if messages of this level are not printed.
+  using TraceSpanType =
+      typename std::conditional<isPrinted(), TraceSpan<msgLevel, sourceClass>,
+                                EmptyTraceSpan>::type;
 };
 
 
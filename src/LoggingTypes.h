@@ -1,6 +1,7 @@
 #ifndef _BRAGI_LOGGING_TYPES_H_
 #define _BRAGI_LOGGING_TYPES_H_
 
+#include <cstdlib>        // parseNumber()
 #include <unordered_map>  // log level prefixes (un-/colored) and LoggingConfig
 #include <string>
 
@@ -30,6 +31,16 @@ struct ComponentConfig
 // Passed configureLogging() to configure the output and style of printed messages
 using LoggingConfig = std::unordered_map<std::string, std::string>;
 
+// returns the numeric value of key in config, or defaultValue if it is missing, empty or 0
+inline unsigned long parseNumber(const LoggingConfig& config, const char* key,
+                                 const unsigned long defaultValue)
+{
+  const auto value = config.find(key);
+  const auto parsed =
+      value != config.end() ? std::strtoul(value->second.c_str(), nullptr, 10) : 0ul;
+  return parsed != 0 ? parsed : defaultValue;
+}
+
 
 // Hasher for Prefix maps
 struct EnumHasher
@@ -66,6 +77,10 @@ struct NO_SOURCE_DEFINED
 
 
 constexpr const char* DEFAULT_LOG_FILE_PATH = "bragi_LOG.txt";  // default for FileLogWriter
+constexpr unsigned long DEFAULT_SCOPE_TIMER_INTERVAL_MS = 1000;  // default for ScopeTimer
+constexpr unsigned long DEFAULT_FLUSH_INTERVAL_MS = 100;  // default for UringLogWriter
+constexpr unsigned long DEFAULT_DUPLICATE_WINDOW_MS = 1000;  // default for DuplicateFilter
+constexpr unsigned long DEFAULT_SHED_WINDOW_MS = 100;  // default for LoadShedder
 
 }  // namespace bragi
 #endif  // _BRAGI_LOG_LEVEL_H_
@@ -20,6 +20,9 @@
     return bragi::Logger<messageLevel>{};               \
   }
 
+#define _BRAGI_CONCAT_IMPL(a, b) a##b
+#define _BRAGI_CONCAT(a, b) _BRAGI_CONCAT_IMPL(a, b)
+
 #define _BRAGI_FUNC_CHOOSER(_f1, _f2, _f3, ...) _f3
 #define _BRAGI_FUNC_RECOMPOSER(argsWithParentheses) \
   _BRAGI_FUNC_CHOOSER argsWithParentheses
@@ -0,0 +1,365 @@
+/**
+ * @file ScopeTimer.h
+ * @brief Implements ScopeTimer and the aggregation of the durations it measures
+ */
+
+#ifndef _BRAGI_SCOPE_TIMER_H_
+#define _BRAGI_SCOPE_TIMER_H_
+
+#include <algorithm>                // pruning of finished threads
+#include <array>                    // ScopeHistogram buckets
+#include <atomic>                   // lock-free recording in ScopeHistogram
+#include <boost/core/demangle.hpp>  // source class prefix of the summary lines
+#include <chrono>                   // measuring durations
+#include <cstdint>
+#include <map>                      // merging histograms by scope
+#include <memory>                   // histograms shared between thread and registry
+#include <mutex>                    // registration and reporting in ScopeTimerRegistry
+#include <sstream>                  // formatting of the summary lines
+#include <typeinfo>                 // source class prefix of the summary lines
+#include <unordered_map>            // per-thread histogram lookup
+#include <vector>
+
+#include "LoggingTypes.h"
+
+namespace bragi {
+
+/**
+ * @brief Log-linear histogram of durations in nanoseconds.
+ *
+ * Each power of two is split into subBucketCount linear sub-buckets, which bounds the
+ * relative error of every bucket to 1/subBucketCount. A histogram is only ever written by
+ * the thread owning it, hence recording is a few relaxed loads and stores. The
+ * ScopeTimerRegistry reads it concurrently when merging.
+ */
+class ScopeHistogram
+{
+ public:
+  static constexpr unsigned subBucketBits = 4;
+  static constexpr std::size_t subBucketCount = std::size_t{1} << subBucketBits;
+  static constexpr std::size_t bucketCount = (64 - subBucketBits + 1) * subBucketCount;
+
+  inline void record(const uint64_t ns) noexcept
+  {
+    increment(buckets_[bucketIndex(ns)], 1, std::memory_order_relaxed);
+    increment(sum_, ns, std::memory_order_relaxed);
+    // publishes bucket and sum: a reader acquiring count_ sees both at least as far
+    increment(count_, 1, std::memory_order_release);
+    uint64_t currentMax = max_.load(std::memory_order_relaxed);
+    while (ns > currentMax &&
+           !max_.compare_exchange_weak(currentMax, ns, std::memory_order_relaxed))
+    {}
+  }
+
+  static inline std::size_t bucketIndex(const uint64_t ns) noexcept
+  {
+    if (ns < subBucketCount) return static_cast<unsigned>(ns);
+    const unsigned shift = highestBit(ns) - subBucketBits;
+    return (shift + 1) * subBucketCount +
+           (static_cast<unsigned>(ns >> shift) & (subBucketCount - 1));
+  }
+
+  static inline uint64_t bucketLowerBound(const std::size_t index) noexcept
+  {
+    if (index < subBucketCount) return index;
+    return uint64_t{subBucketCount + index % subBucketCount} << (index / subBucketCount - 1);
+  }
+
+  static inline uint64_t bucketWidth(const std::size_t index) noexcept
+  {
+    return index < subBucketCount ? 1 : uint64_t{1} << (index / subBucketCount - 1);
+  }
+
+  // @brief returns the midpoint of the bucket holding the requested rank of count
+  //        recorded durations, capped at their maximum
+  static inline uint64_t percentile(const std::array<uint64_t, bucketCount>& buckets,
+                                    const uint64_t count, const uint64_t max,
+                                    const double quantile) noexcept
+  {
+    const auto rank =
+        static_cast<uint64_t>(quantile * static_cast<double>(count - 1)) + 1;
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucketCount; ++i)
+    {
+      seen += buckets[i];
+      if (seen >= rank)
+      {
+        const auto mid = bucketLowerBound(i) + (bucketWidth(i) - 1) / 2;
+        return mid < max ? mid : max;
+      }
+    }
+    return max;
+  }
+
+ private:
+  static inline void increment(std::atomic<uint64_t>& value, const uint64_t summand,
+                               const std::memory_order order) noexcept
+  {
+    // single writer: no read-modify-write instruction necessary
+    value.store(value.load(std::memory_order_relaxed) + summand, order);
+  }
+
+  static inline unsigned highestBit(uint64_t value) noexcept
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#else
+    unsigned bit = 0;
+    while (value >>= 1) ++bit;
+    return bit;
+#endif
+  }
+
+  std::array<std::atomic<uint64_t>, bucketCount> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+
+  friend class ScopeTimerRegistry;
+};
+
+
+/**
+ * @brief Owns all ScopeHistograms of all threads, merges them by scope and periodically
+ * logs one summary line per scope.
+ *
+ * The summaries cover the durations recorded since the previous report. Reports are
+ * triggered by the first ScopeTimer finishing after the configured "timer_interval"
+ * (see configureLogging()) has passed, and once more at program exit.
+ */
+class ScopeTimerRegistry
+{
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static inline ScopeTimerRegistry& instance()
+  {
+    static ScopeTimerRegistry registry;
+    return registry;
+  }
+
+  ~ScopeTimerRegistry() { report(); }
+
+  ScopeTimerRegistry(const ScopeTimerRegistry& other) = delete;
+  ScopeTimerRegistry(ScopeTimerRegistry&& other) = delete;
+  ScopeTimerRegistry operator=(ScopeTimerRegistry&& other) = delete;
+  ScopeTimerRegistry operator=(const ScopeTimerRegistry& other) = delete;
+
+  inline std::shared_ptr<ScopeHistogram> registerHistogram(std::string label,
+                                                           const LogLevel level)
+  {
+    auto entry = std::make_unique<Entry>();
+    entry->label = std::move(label);
+    entry->level = level;
+    entry->histogram = std::make_shared<ScopeHistogram>();
+    auto histogram = entry->histogram;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back(std::move(entry));
+    return histogram;
+  }
+
+  inline void reportIfDue(const Clock::time_point now)
+  {
+    const auto nowNs = toNs(now);
+    auto nextReport = nextReport_.load(std::memory_order_relaxed);
+    if (nowNs < nextReport) return;
+    if (nextReport_.compare_exchange_strong(nextReport, nowNs + intervalNs(),
+                                            std::memory_order_relaxed))
+      report();
+  }
+
+ private:
+  struct Entry
+  {
+    std::string label;
+    LogLevel level;
+    std::shared_ptr<ScopeHistogram> histogram;
+    std::array<uint64_t, ScopeHistogram::bucketCount> reportedBuckets{};
+    uint64_t reportedCount = 0;
+    uint64_t reportedSum = 0;
+    bool finished = false;
+  };
+
+  struct Summary
+  {
+    std::array<uint64_t, ScopeHistogram::bucketCount> buckets{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+  };
+
+  inline ScopeTimerRegistry()
+      : interval_{LogWriterPolicy::get().scopeTimerInterval_}  // LogWriter outlives this
+      , nextReport_{toNs(Clock::now()) + intervalNs()}
+  {}
+
+  inline std::chrono::nanoseconds::rep intervalNs() const
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(interval_).count();
+  }
+
+  static inline std::chrono::nanoseconds::rep toNs(const Clock::time_point time)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch())
+        .count();
+  }
+
+  inline void report()
+  {
+    std::map<std::pair<std::string, LogLevel>, Summary> summaries;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto& entry : entries_)
+      {
+        // histograms only referenced by the registry belong to finished threads. This is
+        // tested before merging: a thread finishing during the merge may record after its
+        // histogram was read, so it is only removed after the next report.
+        entry->finished = entry->histogram.use_count() == 1;
+        auto& summary = summaries[{entry->label, entry->level}];
+        auto& histogram = *entry->histogram;
+        // count is acquired first: the buckets and sum may only be ahead of it, never
+        // behind (see ScopeHistogram::record)
+        const auto count = histogram.count_.load(std::memory_order_acquire);
+        const auto sum = histogram.sum_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < ScopeHistogram::bucketCount; ++i)
+        {
+          const auto bucket = histogram.buckets_[i].load(std::memory_order_relaxed);
+          summary.buckets[i] += bucket - entry->reportedBuckets[i];
+          entry->reportedBuckets[i] = bucket;
+        }
+        summary.count += count - entry->reportedCount;
+        summary.sum += sum - entry->reportedSum;
+        entry->reportedCount = count;
+        entry->reportedSum = sum;
+        const auto max = histogram.max_.exchange(0, std::memory_order_relaxed);
+        if (max > summary.max) summary.max = max;
+      }
+
+      entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                    [](const std::unique_ptr<Entry>& entry) {
+                                      return entry->finished;
+                                    }),
+                     entries_.end());
+    }
+
+    for (const auto& scope : summaries)
+    {
+      const auto& summary = scope.second;
+      if (summary.count == 0) continue;
+      std::ostringstream line;
+      line << scope.first.first << ": count=" << summary.count
+           << " mean=" << formatDuration(summary.sum / summary.count)
+           << " p50=" << formatDuration(percentile(summary, 0.5))
+           << " p99=" << formatDuration(percentile(summary, 0.99))
+           << " max=" << formatDuration(summary.max);
+      LogWriterPolicy::log(line.str(), scope.first.second);
+    }
+  }
+
+  static inline uint64_t percentile(const Summary& summary, const double quantile)
+  {
+    return ScopeHistogram::percentile(summary.buckets, summary.count, summary.max,
+                                      quantile);
+  }
+
+  static inline std::string formatDuration(const uint64_t ns)
+  {
+    std::ostringstream formatted;
+    formatted.precision(3);
+    if (ns < 1000u)
+      formatted << ns << "ns";
+    else if (ns < 1000000u)
+      formatted << std::fixed << static_cast<double>(ns) * 1e-3 << "µs";
+    else if (ns < 1000000000u)
+      formatted << std::fixed << static_cast<double>(ns) * 1e-6 << "ms";
+    else
+      formatted << std::fixed << static_cast<double>(ns) * 1e-9 << "s";
+    return formatted.str();
+  }
+
+  const std::chrono::milliseconds interval_;
+  std::atomic<std::chrono::nanoseconds::rep> nextReport_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Entry>> entries_;
+};
+
+
+class EmptyScopeTimer
+{
+ public:
+  constexpr explicit EmptyScopeTimer(const char*) noexcept {}
+  // A user provided destructor makes the type non-trivial, hence compilers do not warn
+  // about the unused variable, which LOG_SCOPE_TIMER declares when it is compiled out.
+  ~EmptyScopeTimer() {}
+
+  EmptyScopeTimer(const EmptyScopeTimer& other) = delete;
+  EmptyScopeTimer(EmptyScopeTimer&& other) = delete;
+  EmptyScopeTimer operator=(EmptyScopeTimer&& other) = delete;
+  EmptyScopeTimer operator=(const EmptyScopeTimer& other) = delete;
+};
+
+
+/**
+ * @brief Measures the lifetime of the instance and records it into the histogram of the
+ * current thread for the scope name passed to the constructor.
+ *
+ * Use it via LOG_SCOPE_TIMER. Scopes are identified by name, source class and level;
+ * timers of the same scope on different threads are merged into one summary line.
+ */
+template <LogLevel logLevel, class sourceClass>
+class ScopeTimer
+{
+ public:
+  explicit ScopeTimer(const char* name)
+      : histogram_{threadHistogram(name)}, start_{ScopeTimerRegistry::Clock::now()}
+  {}
+
+  ~ScopeTimer()
+  {
+    const auto end = ScopeTimerRegistry::Clock::now();
+    histogram_.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_).count()));
+    ScopeTimerRegistry::instance().reportIfDue(end);
+  }
+
+  ScopeTimer(const ScopeTimer& other) = delete;
+  ScopeTimer(ScopeTimer&& other) = delete;
+  ScopeTimer operator=(ScopeTimer&& other) = delete;
+  ScopeTimer operator=(const ScopeTimer& other) = delete;
+
+ private:
+  // names are expected to be string literals, hence the lookup by address
+  static inline ScopeHistogram& threadHistogram(const char* name)
+  {
+    struct ThreadHistograms
+    {
+      const char* lastName = nullptr;
+      ScopeHistogram* last = nullptr;
+      std::unordered_map<const char*, std::shared_ptr<ScopeHistogram>> all;
+    };
+    thread_local ThreadHistograms local;
+
+    if (name == local.lastName) return *local.last;
+    auto& histogram = local.all[name];
+    if (!histogram)
+      histogram = ScopeTimerRegistry::instance().registerHistogram(label(name), logLevel);
+    local.lastName = name;
+    local.last = histogram.get();
+    return *histogram;
+  }
+
+  static inline std::string label(const char* name)
+  {
+    std::string label;
+    if (typeid(sourceClass) != typeid(NO_SOURCE_DEFINED))
+      label = '[' + boost::core::demangle(typeid(sourceClass).name()) + "] ";
+    return label + "scope \"" + name + '"';
+  }
+
+  ScopeHistogram& histogram_;
+  const ScopeTimerRegistry::Clock::time_point start_;
+};
+
+}  // namespace bragi
+#endif  // _BRAGI_SCOPE_TIMER_H_
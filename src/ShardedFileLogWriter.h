@@ -0,0 +1,137 @@
+/**
+ * @file ShardedFileLogWriter.h
+ * @brief Implements ShardedFileLogWriter, a LogWriter with one output file per thread.
+ * It should not be included directly, it is part of LogWriter.h
+ */
+
+#ifndef _BRAGI_SHARDED_FILE_LOG_WRITER_H_
+#define _BRAGI_SHARDED_FILE_LOG_WRITER_H_
+
+#include <atomic>   // global sequence number and shard index
+#include <chrono>   // record timestamps
+#include <cstdint>
+#include <fstream>  // the shard files
+#include <memory>   // thread local shards
+#include <string>
+#include <vector>
+
+namespace bragi {
+
+/**
+ * @brief LogWriter which writes every thread into its own file, without any lock.
+ *
+ * Each thread lazily opens the shard `<path>.<n>`, where n = 1, 2, ... is assigned in the
+ * order of the first message of each thread. Thread ids are not used in the names: the OS
+ * reuses them, and a new thread would truncate the shard of a finished one. The shards are
+ * buffered and written, when the buffer is full and when the thread exits. Every record
+ * has the format
+ *
+ *   <timestamp> <sequence> <size> <prefixed message>\n
+ *
+ * with the steady clock timestamp in nanoseconds, the global sequence number of the
+ * message and the size of the prefixed message in bytes (it may contain line breaks).
+ * The tool bragi_merge merges all shards into one ordered log:
+ *
+ *   bragi_merge <path>.* > <path>
+ */
+class ShardedFileLogWriter final : public LogWriter
+{
+ public:
+  explicit ShardedFileLogWriter(const LoggingConfig& config)
+      : LogWriter{config}
+      , path_{config.find("path") != config.end() ? config.find("path")->second
+                                                  : DEFAULT_LOG_FILE_PATH}
+      , duplicateWindow_{DuplicateFilter::parseWindow(config)}
+  {}
+
+  ShardedFileLogWriter() = delete;
+  ShardedFileLogWriter(const ShardedFileLogWriter& other) = delete;
+  ShardedFileLogWriter(ShardedFileLogWriter&& other) = delete;
+  ShardedFileLogWriter operator=(ShardedFileLogWriter&& other) = delete;
+  ShardedFileLogWriter operator=(const ShardedFileLogWriter& other) = delete;
+
+  inline void log(const std::string&& message, const LogLevel level) override
+  {
+    auto& shard = threadShard();
+    const auto hash = shard.duplicates.fingerprint(message);
+    if (!shard.duplicates.pass(message, hash, level, shard)) return;
+    const auto sequence = sequence_.fetch_add(1, std::memory_order_relaxed);
+    writeRecord(shard.file, now(), sequence, prefix(level), message);
+  }
+
+  inline void logBatch(const std::vector<std::string>&& messages,
+                       const LogLevel level) override
+  {
+    auto& shard = threadShard();
+    shard.duplicates.interrupt(shard);
+    // consecutive sequence numbers and a shared timestamp keep the batch contiguous
+    auto sequence = sequence_.fetch_add(messages.size(), std::memory_order_relaxed);
+    const auto timestamp = now();
+    const auto linePrefix = prefix(level);
+    for (const auto& message : messages)
+      writeRecord(shard.file, timestamp, sequence++, linePrefix, message);
+  }
+
+ private:
+  // duplicates are suppressed per thread, as there is no common order of the messages
+  struct Shard
+  {
+    explicit Shard(ShardedFileLogWriter& writer)
+        : owner{writer}, duplicates{writer.duplicateWindow_}
+    {}
+    ~Shard() { duplicates.interrupt(*this); }
+    Shard(const Shard& other) = delete;
+    Shard operator=(const Shard& other) = delete;
+
+    inline void printSummary(const std::string& summary, const LogLevel level)
+    {
+      owner.writeRecord(file, now(),
+                        owner.sequence_.fetch_add(1, std::memory_order_relaxed),
+                        owner.prefix(level), summary);
+    }
+
+    ShardedFileLogWriter& owner;
+    std::unique_ptr<char[]> buffer{new char[bufferSize]};
+    std::ofstream file;
+    DuplicateFilter duplicates;
+  };
+
+  static constexpr std::size_t bufferSize = 64 * 1024;
+
+  inline Shard& threadShard()
+  {
+    thread_local std::unique_ptr<Shard> shard;
+    if (!shard || &shard->owner != this)
+    {
+      shard.reset(new Shard{*this});
+      shard->file.rdbuf()->pubsetbuf(shard->buffer.get(), bufferSize);
+      const auto index = nextShard_.fetch_add(1, std::memory_order_relaxed);
+      shard->file.open(path_ + '.' + std::to_string(index),
+                       std::ofstream::out | std::ofstream::trunc);
+    }
+    return *shard;
+  }
+
+  static inline uint64_t now()
+  {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+  }
+
+  static inline void writeRecord(std::ofstream& file, const uint64_t timestamp,
+                                 const uint64_t sequence, const std::string& linePrefix,
+                                 const std::string& message)
+  {
+    file << timestamp << ' ' << sequence << ' ' << linePrefix.size() + message.size()
+         << ' ' << linePrefix << message << '\n';
+  }
+
+  const std::string path_;
+  std::atomic<uint64_t> sequence_{0};
+  std::atomic<unsigned> nextShard_{1};
+  const std::chrono::milliseconds duplicateWindow_;
+};
+
+}  // namespace bragi
+#endif  // _BRAGI_SHARDED_FILE_LOG_WRITER_H_
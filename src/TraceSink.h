@@ -0,0 +1,346 @@
+/**
+ * @file TraceSink.h
+ * @brief Implements TraceSink and TraceSpan: export of spans and logged messages in the
+ * Chrome trace-event format (chrome://tracing, https://ui.perfetto.dev)
+ */
+
+#ifndef _BRAGI_TRACE_SINK_H_
+#define _BRAGI_TRACE_SINK_H_
+
+#include <algorithm>                // pruning of finished threads
+#include <array>                    // TraceSink::Chunk
+#include <atomic>                   // lock-free hand over of recorded events
+#include <boost/core/demangle.hpp>  // trace category from the source class
+#include <chrono>                   // event timestamps
+#include <cstdint>
+#include <fstream>                  // the trace file
+#include <memory>                   // thread buffers shared between thread and sink
+#include <mutex>                    // registration and flushing
+#include <string>
+#include <typeinfo>                 // trace category from the source class
+#include <vector>
+
+#include "LoggingTypes.h"
+
+namespace bragi {
+
+class TraceSink;
+
+/**
+ * @brief Holds the TraceSink created by configureLogging(), null while tracing is
+ * disabled.
+ *
+ * A static data member of a class template is constant-initialized, hence every logged
+ * message tests a plain atomic pointer, without a static initialization guard.
+ */
+template <class = void>
+struct ActiveTraceSink
+{
+  static std::atomic<TraceSink*> sink;
+};
+
+template <class T>
+std::atomic<TraceSink*> ActiveTraceSink<T>::sink{nullptr};
+
+// returns the TraceSink or nullptr, if tracing is disabled
+inline TraceSink* activeTraceSink() noexcept
+{
+  return ActiveTraceSink<>::sink.load(std::memory_order_acquire);
+}
+
+
+/**
+ * @brief Records spans and logged messages into per-thread buffers and serializes them as
+ * Chrome trace-event JSON.
+ *
+ * Tracing is enabled by passing {"trace", "<path>"} to configureLogging(). Recording an
+ * event only writes to a buffer owned by the calling thread and publishes it with a single
+ * release store, it never takes a lock. The recorded events are appended to the trace file
+ * by flushTrace() and when the program exits.
+ */
+class TraceSink
+{
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit TraceSink(const LoggingConfig& config) : origin_{Clock::now()}
+  {
+    const auto path = config.find("trace");
+    if (path == config.end()) return;
+    file_.open(path->second, std::ofstream::out | std::ofstream::trunc);
+    enabled_ = file_.is_open();
+    if (enabled_) file_ << "{\"traceEvents\":[";
+  }
+
+  ~TraceSink()
+  {
+    if (!enabled_) return;
+    ActiveTraceSink<>::sink.store(nullptr, std::memory_order_release);
+    flush();
+    file_ << "\n]}\n";
+  }
+
+  TraceSink() = delete;
+  TraceSink(const TraceSink& other) = delete;
+  TraceSink(TraceSink&& other) = delete;
+  TraceSink operator=(TraceSink&& other) = delete;
+  TraceSink operator=(const TraceSink& other) = delete;
+
+  inline bool enabled() const noexcept { return enabled_; }
+
+  // @param phase    'B' (span begin), 'E' (span end) or 'i' (instant, a logged message)
+  // @param name     name of the span, has to outlive the sink (i.e. a string literal)
+  // @param message  the logged message, only used for instant events
+  inline void record(const char phase, const LogLevel level, const std::string& category,
+                     const char* name, std::string message = {})
+  {
+    auto& buffer = threadBuffer();
+    auto size = buffer.tail->size.load(std::memory_order_relaxed);
+    if (size == Chunk::capacity)
+    {
+      auto* chunk = new Chunk;
+      buffer.tail->next.store(chunk, std::memory_order_release);
+      buffer.tail = chunk;
+      size = 0;
+    }
+    auto& event = buffer.tail->events[size];
+    event.phase = phase;
+    event.level = level;
+    event.timestamp = Clock::now();
+    event.category = &category;
+    event.name = name;
+    event.message = std::move(message);
+    buffer.tail->size.store(size + 1, std::memory_order_release);
+  }
+
+  // appends all events recorded so far to the trace file and releases their memory
+  inline void flush()
+  {
+    if (!enabled_) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& buffer : buffers_)
+    {
+      // buffers only referenced by the sink belong to finished threads. This is tested
+      // before draining: a thread finishing during the flush may record after its buffer
+      // was drained, so it is only removed after the next flush.
+      buffer->finished = buffer.use_count() == 1;
+      if (!buffer->announced)
+      {
+        separate();
+        file_ << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+              << ",\"args\":{\"name\":\"thread " << buffer->tid << "\"}}";
+        buffer->announced = true;
+      }
+      while (true)
+      {
+        auto* chunk = buffer->head;
+        const auto size = chunk->size.load(std::memory_order_acquire);
+        for (; buffer->consumed < size; ++buffer->consumed)
+          write(chunk->events[buffer->consumed], buffer->tid);
+
+        // the owning thread never touches a chunk again, once it has a successor
+        auto* next = chunk->next.load(std::memory_order_acquire);
+        if (size != Chunk::capacity || next == nullptr) break;
+        buffer->head = next;
+        buffer->consumed = 0;
+        delete chunk;
+      }
+    }
+    file_.flush();
+
+    buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                  [](const std::shared_ptr<ThreadBuffer>& buffer) {
+                                    return buffer->finished;
+                                  }),
+                   buffers_.end());
+  }
+
+  // returns the category for all events of sourceClass
+  template <class sourceClass>
+  static inline const std::string& category()
+  {
+    static const std::string category{
+        typeid(sourceClass) != typeid(NO_SOURCE_DEFINED)
+            ? boost::core::demangle(typeid(sourceClass).name())
+            : "bragi"};
+    return category;
+  }
+
+ private:
+  struct Event
+  {
+    char phase;
+    LogLevel level;
+    Clock::time_point timestamp;
+    const std::string* category;
+    const char* name;
+    std::string message;
+  };
+
+  struct Chunk
+  {
+    static constexpr std::size_t capacity = 512;
+    std::array<Event, capacity> events;
+    std::atomic<std::size_t> size{0};
+    std::atomic<Chunk*> next{nullptr};
+  };
+
+  // the owning thread appends at tail, the sink consumes from head
+  struct ThreadBuffer
+  {
+    explicit ThreadBuffer(const unsigned threadId)
+        : tid{threadId}, head{new Chunk}, tail{head}
+    {}
+    ~ThreadBuffer()
+    {
+      while (head != nullptr)
+      {
+        auto* next = head->next.load(std::memory_order_relaxed);
+        delete head;
+        head = next;
+      }
+    }
+    ThreadBuffer(const ThreadBuffer& other) = delete;
+    ThreadBuffer operator=(const ThreadBuffer& other) = delete;
+
+    const unsigned tid;
+    Chunk* head;
+    Chunk* tail;
+    std::size_t consumed = 0;
+    bool announced = false;
+    bool finished = false;
+  };
+
+  inline ThreadBuffer& threadBuffer()
+  {
+    thread_local std::shared_ptr<ThreadBuffer> buffer{registerThread()};
+    return *buffer;
+  }
+
+  inline std::shared_ptr<ThreadBuffer> registerThread()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.push_back(std::make_shared<ThreadBuffer>(nextThreadId_++));
+    return buffers_.back();
+  }
+
+  inline void separate()
+  {
+    file_ << (firstEvent_ ? "\n" : ",\n");
+    firstEvent_ = false;
+  }
+
+  inline void write(const Event& event, const unsigned tid)
+  {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        event.timestamp - origin_)
+                        .count();
+    separate();
+    file_ << "{\"name\":\"";
+    if (event.phase == 'i')
+      writeEscaped(event.message);
+    else
+      writeEscaped(event.name);
+    file_ << "\",\"cat\":\"";
+    writeEscaped(*event.category);
+    file_ << "\",\"ph\":\"" << event.phase << "\",\"ts\":" << ns / 1000 << '.'
+          << std::to_string(1000 + ns % 1000).substr(1) << ",\"pid\":1,\"tid\":" << tid;
+    if (event.phase == 'i')
+      file_ << ",\"s\":\"t\",\"args\":{\"level\":\"" << levelName(event.level) << "\"}";
+    file_ << '}';
+  }
+
+  inline void writeEscaped(const std::string& text)
+  {
+    for (const char c : text)
+    {
+      switch (c)
+      {
+        case '"': file_ << "\\\""; break;
+        case '\\': file_ << "\\\\"; break;
+        case '\n': file_ << "\\n"; break;
+        case '\t': file_ << "\\t"; break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20)
+          {
+            const char* hex = "0123456789abcdef";
+            file_ << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+          }
+          else
+            file_ << c;
+      }
+    }
+  }
+
+  static inline std::string levelName(const LogLevel level)
+  {
+    const auto prefix = uncoloredPrefixes.find(level);
+    if (prefix == uncoloredPrefixes.end())
+      return "CUSTOM:" + std::to_string(static_cast<uint8_t>(level));
+    const auto& name = prefix->second;
+    return name.substr(1, name.find(']') - 1);
+  }
+
+  const Clock::time_point origin_;
+  bool enabled_ = false;
+  bool firstEvent_ = true;
+  unsigned nextThreadId_ = 1;
+  std::ofstream file_;
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+};
+
+
+// creates the TraceSink on the first call, later calls do not change it
+inline void configureTraceSink(const LoggingConfig& config)
+{
+  static TraceSink sink{config};
+  if (sink.enabled()) ActiveTraceSink<>::sink.store(&sink, std::memory_order_release);
+}
+
+
+/**
+ * @brief Records a begin event on construction and an end event on destruction, if
+ * tracing is enabled. Use it via LOG_SPAN.
+ */
+template <LogLevel logLevel, class sourceClass>
+class TraceSpan
+{
+ public:
+  explicit TraceSpan(const char* name) : sink_{activeTraceSink()}, name_{name}
+  {
+    if (sink_ != nullptr)
+      sink_->record('B', logLevel, TraceSink::category<sourceClass>(), name_);
+  }
+
+  ~TraceSpan()
+  {
+    if (sink_ != nullptr)
+      sink_->record('E', logLevel, TraceSink::category<sourceClass>(), name_);
+  }
+
+  TraceSpan(const TraceSpan& other) = delete;
+  TraceSpan(TraceSpan&& other) = delete;
+  TraceSpan operator=(TraceSpan&& other) = delete;
+  TraceSpan operator=(const TraceSpan& other) = delete;
+
+ private:
+  TraceSink* const sink_;  // the end event goes to the sink, which got the begin event
+  const char* name_;
+};
+
+
+class EmptyTraceSpan
+{
+ public:
+  constexpr explicit EmptyTraceSpan(const char*) noexcept {}
+  ~EmptyTraceSpan() {}  // user provided, see EmptyScopeTimer
+
+  EmptyTraceSpan(const EmptyTraceSpan& other) = delete;
+  EmptyTraceSpan(EmptyTraceSpan&& other) = delete;
+  EmptyTraceSpan operator=(EmptyTraceSpan&& other) = delete;
+  EmptyTraceSpan operator=(const EmptyTraceSpan& other) = delete;
+};
+
+}  // namespace bragi
+#endif  // _BRAGI_TRACE_SINK_H_
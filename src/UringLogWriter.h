@@ -0,0 +1,451 @@
+/**
+ * @file UringLogWriter.h
+ * @brief Implements UringLogWriter, a file LogWriter submitting its writes via io_uring.
+ * It should not be included directly, it is part of LogWriter.h
+ */
+
+#ifndef _BRAGI_URING_LOG_WRITER_H_
+#define _BRAGI_URING_LOG_WRITER_H_
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define BRAGI_HAS_IO_URING
+#endif
+#endif
+
+#ifdef BRAGI_HAS_IO_URING
+
+#include <fcntl.h>           // open()
+#include <linux/io_uring.h>  // io_uring structures and constants
+#include <sys/mman.h>        // mapping of the rings
+#include <sys/syscall.h>     // io_uring syscalls (no liburing dependency)
+#include <sys/uio.h>         // iovec for the registered buffers
+#include <unistd.h>          // close(), pwrite(), ftruncate()
+
+#include <algorithm>  // std::min, std::max
+#include <cerrno>
+#include <chrono>   // flush interval
+#include <cstdlib>  // posix_memalign()
+#include <cstring>  // memcpy()
+#include <string>
+#include <vector>
+
+namespace bragi {
+
+/**
+ * @brief LogWriter which collects the printed messages in fixed-size blocks and writes
+ * every full block with a single io_uring submission.
+ *
+ * The blocks are registered with the kernel once (IORING_OP_WRITE_FIXED), so logging a
+ * message is a memcpy into the current block. A syscall is only made when a block is
+ * submitted, and it only blocks if all blocks are still in flight. A block is submitted
+ * when it is full, when a message is logged after the oldest unsubmitted message waited
+ * for the flush interval, and when the writer is destroyed. There is no timer: without
+ * further messages, messages below warn stay in memory until the writer is destroyed.
+ * A message with level warn or higher is submitted immediately, without waiting for the
+ * write. For messages with "sync_level" or higher, log() also waits until all submitted
+ * writes are completed, so they survive a following abort() or crash.
+ *
+ * With O_DIRECT a partial block is written padded with zeros; its last incomplete page is
+ * rewritten with the following block. Until then the file ends with up to 4095 zeros.
+ *
+ * Configuration (in addition to "path" and "color"):
+ *   {"direct", ""}            open the file with O_DIRECT (if the file system supports it)
+ *   {"block_size", "<n>"}     size of each block in bytes, rounded up to 4096 (default 64KiB)
+ *   {"blocks", "<n>"}         number of blocks (default 16)
+ *   {"flush_interval", "<ms>"} maximum age of unsubmitted messages, checked whenever a
+ *                             message is logged (default: DEFAULT_FLUSH_INTERVAL_MS)
+ *   {"sync_level", "<level>"} level name (e.g. "warn") or number, from which on log()
+ *                             waits for the write (default: never)
+ *
+ * If io_uring is unavailable isValid() returns false, see createLogWriter().
+ */
+class UringLogWriter : public LogWriter
+{
+ public:
+  explicit UringLogWriter(const LoggingConfig& config)
+      : LogWriter{config}
+      , blockSize_{alignUp(parseNumber(config, "block_size", 64 * 1024))}
+      , blockCount_{static_cast<unsigned>(parseNumber(config, "blocks", 16))}
+      , flushInterval_{parseNumber(config, "flush_interval", DEFAULT_FLUSH_INTERVAL_MS)}
+      , syncLevel_{parseSyncLevel(config)}
+  {
+    if (!setupRing() || !setupBlocks() || !openFile(config)) release();
+  }
+
+  ~UringLogWriter()
+  {
+    if (!isValid()) return;
+    std::lock_guard<std::mutex> lock(logMutex_);
+    duplicates_.interrupt(*this);
+    loadShedder_.finish(*this);
+    const auto written = offset_ + fill_;
+    if (fill_ != 0)
+    {
+      // O_DIRECT requires aligned lengths: pad the last block and truncate afterwards
+      if (direct_) std::memset(block(current_) + fill_, 0, blockSize_ - fill_);
+      submit(direct_ ? blockSize_ : fill_);
+    }
+    waitForWrites();
+    if (direct_ && ftruncate(fileFd_, static_cast<off_t>(written)) != 0) {}
+    release();
+  }
+
+  UringLogWriter() = delete;
+  UringLogWriter(const UringLogWriter& other) = delete;
+  UringLogWriter(UringLogWriter&& other) = delete;
+  UringLogWriter operator=(UringLogWriter&& other) = delete;
+  UringLogWriter operator=(const UringLogWriter& other) = delete;
+
+  inline bool isValid() const noexcept { return fileFd_ >= 0; }
+
+  inline void log(const std::string&& message, const LogLevel level) override
+  {
+    if (loadShedder_.shed(level)) return;
+    const auto hash = duplicates_.fingerprint(message);
+    const auto arrival = loadShedder_.arrive();
+    std::lock_guard<std::mutex> lock(logMutex_);
+    if (duplicates_.pass(message, hash, level, *this)) print(message, level);
+    flushIfDue(level);
+    loadShedder_.depart(arrival, level, *this);
+  }
+
+  inline void logBatch(const std::vector<std::string>&& messages,
+                       const LogLevel level) override
+  {
+    if (loadShedder_.shed(level)) return;
+    const auto block = joinLines(messages, level);
+    const auto arrival = loadShedder_.arrive();
+    std::lock_guard<std::mutex> lock(logMutex_);
+    duplicates_.interrupt(*this);
+    append(block);
+    flushIfDue(level);
+    loadShedder_.depart(arrival, level, *this);
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  static constexpr std::size_t alignment = 4096;  // satisfies O_DIRECT on common devices
+
+  inline void print(const std::string& message, const LogLevel level)
+  {
+    const auto prefixSearch = logPrefixes_.find(level);
+    if (prefixSearch != logPrefixes_.end())
+      append(prefixSearch->second);
+    else
+      append("[CUSTOM:" + std::to_string(static_cast<uint8_t>(level)) + "] ");
+    append(message);
+    append("\n");
+  }
+
+  inline void printSummary(const std::string& summary, const LogLevel level)
+  {
+    append(prefix(level) + summary + '\n');
+  }
+  friend class DuplicateFilter;
+  friend class LoadShedder;
+
+  static constexpr int noSyncLevel = 256;  // above all levels, log() never waits
+
+  static inline int parseSyncLevel(const LoggingConfig& config)
+  {
+    const auto value = config.find("sync_level");
+    if (value == config.end()) return noSyncLevel;
+    const char* const names[] = {"trace", "debug", "eval", "info",
+                                 "warn",  "error", "dev"};
+    for (int i = 0; i < 7; ++i)
+      if (value->second == names[i]) return static_cast<int>(LogLevel::trace) + i;
+    return static_cast<int>(parseNumber(config, "sync_level", noSyncLevel));
+  }
+
+  static inline std::size_t alignUp(const std::size_t size)
+  {
+    return (size + alignment - 1) / alignment * alignment;
+  }
+
+  inline char* block(const unsigned index) const noexcept
+  {
+    return blocks_ + std::size_t{index} * blockSize_;
+  }
+
+  inline bool setupRing()
+  {
+    io_uring_params params{};
+    ringFd_ = static_cast<int>(syscall(__NR_io_uring_setup, blockCount_, &params));
+    if (ringFd_ < 0) return false;
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+
+    sqRing_ = mapRing(sqRingSize_, IORING_OFF_SQ_RING);
+    if (sqRing_ == nullptr) return false;
+    cqRing_ = singleMmap ? sqRing_ : mapRing(cqRingSize_, IORING_OFF_CQ_RING);
+    if (cqRing_ == nullptr) return false;
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = reinterpret_cast<io_uring_sqe*>(mapRing(sqesSize_, IORING_OFF_SQES));
+    if (sqes_ == nullptr) return false;
+
+    sqTail_ = reinterpret_cast<unsigned*>(sqRing_ + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sqRing_ + params.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned*>(sqRing_ + params.sq_off.array);
+    cqHead_ = reinterpret_cast<unsigned*>(cqRing_ + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cqRing_ + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cqRing_ + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cqRing_ + params.cq_off.cqes);
+    return true;
+  }
+
+  inline char* mapRing(const std::size_t size, const unsigned long long offset)
+  {
+    void* ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringFd_, static_cast<off_t>(offset));
+    return ring != MAP_FAILED ? static_cast<char*>(ring) : nullptr;
+  }
+
+  inline bool setupBlocks()
+  {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignment, blockSize_ * blockCount_) != 0) return false;
+    blocks_ = static_cast<char*>(memory);
+
+    std::vector<iovec> iovecs(blockCount_);
+    for (unsigned i = 0; i < blockCount_; ++i)
+    {
+      iovecs[i].iov_base = block(i);
+      iovecs[i].iov_len = blockSize_;
+      freeBlocks_.push_back(blockCount_ - 1 - i);
+    }
+    if (syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_BUFFERS, iovecs.data(),
+                blockCount_) != 0)
+      return false;
+    buffersRegistered_ = true;
+
+    blockOffsets_.resize(blockCount_);
+    blockLengths_.resize(blockCount_);
+    current_ = freeBlocks_.back();
+    freeBlocks_.pop_back();
+    return true;
+  }
+
+  inline bool openFile(const LoggingConfig& config)
+  {
+    const auto path = config.find("path") != config.end() ? config.find("path")->second
+                                                          : DEFAULT_LOG_FILE_PATH;
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if (config.find("direct") != config.end())
+    {
+      fileFd_ = open(path.c_str(), flags | O_DIRECT, 0644);
+      direct_ = fileFd_ >= 0;
+    }
+    if (fileFd_ < 0) fileFd_ = open(path.c_str(), flags, 0644);
+    return fileFd_ >= 0;
+  }
+
+  inline void release()
+  {
+    if (fileFd_ >= 0) close(fileFd_);
+    if (buffersRegistered_)
+      syscall(__NR_io_uring_register, ringFd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+    if (sqes_ != nullptr) munmap(sqes_, sqesSize_);
+    if (cqRing_ != nullptr && cqRing_ != sqRing_) munmap(cqRing_, cqRingSize_);
+    if (sqRing_ != nullptr) munmap(sqRing_, sqRingSize_);
+    if (ringFd_ >= 0) close(ringFd_);
+    std::free(blocks_);
+    fileFd_ = ringFd_ = -1;
+    buffersRegistered_ = false;
+    sqes_ = nullptr;
+    sqRing_ = cqRing_ = blocks_ = nullptr;
+  }
+
+  inline void append(const std::string& text)
+  {
+    const char* data = text.data();
+    std::size_t size = text.size();
+    while (size != 0)
+    {
+      const auto chunk = std::min(size, blockSize_ - fill_);
+      std::memcpy(block(current_) + fill_, data, chunk);
+      if (!unsubmitted_)
+      {
+        unsubmitted_ = true;
+        unsubmittedSince_ = Clock::now();
+      }
+      fill_ += chunk;
+      data += chunk;
+      size -= chunk;
+      if (fill_ == blockSize_)
+      {
+        submit(blockSize_);
+        nextBlock();
+      }
+    }
+  }
+
+  // warnings and errors are handed to the kernel when log() returns. Messages with
+  // syncLevel_ or higher are on disk (or in the page cache), so they survive a following
+  // abort() or crash together with all messages before them.
+  inline void flushIfDue(const LogLevel level)
+  {
+    const bool sync = static_cast<int>(level) >= syncLevel_;
+    if (unsubmitted_ && (sync || level >= LogLevel::warn ||
+                         Clock::now() - unsubmittedSince_ >= flushInterval_))
+      submitPartial();
+    if (sync) waitForWrites();
+  }
+
+  // submits the partially filled block and continues in the next one
+  inline void submitPartial()
+  {
+    if (!direct_)
+    {
+      submit(fill_);
+      nextBlock();
+      return;
+    }
+    // O_DIRECT requires aligned offsets and lengths: the last incomplete page is carried
+    // over to the next block and rewritten, strictly after this write (IOSQE_IO_DRAIN)
+    const auto carried = fill_ % alignment;
+    const auto carriedFrom = block(current_) + fill_ - carried;
+    std::memset(block(current_) + fill_, 0, alignUp(fill_) - fill_);
+    const auto submitted = current_;
+    submit(alignUp(fill_));
+    // a failed write must not be retried over the newer copy of the carried page
+    if (carried != 0) blockLengths_[submitted] -= alignment;
+    nextBlock();
+    std::memmove(block(current_), carriedFrom, carried);  // nextBlock() may reuse it
+    offset_ -= carried;
+    fill_ = carried;
+    drainNext_ = carried != 0;
+  }
+
+  // queues the current block and hands it to the kernel without waiting for completion
+  inline void submit(const std::size_t length)
+  {
+    const unsigned tail = *sqTail_;
+    const unsigned index = tail & sqMask_;
+    io_uring_sqe& sqe = sqes_[index];
+    sqe = io_uring_sqe{};
+    sqe.opcode = IORING_OP_WRITE_FIXED;
+    sqe.fd = fileFd_;
+    sqe.addr = reinterpret_cast<unsigned long long>(block(current_));
+    sqe.len = static_cast<unsigned>(length);
+    sqe.off = offset_;
+    sqe.buf_index = static_cast<uint16_t>(current_);
+    sqe.user_data = current_;
+    if (drainNext_) sqe.flags = IOSQE_IO_DRAIN;
+    drainNext_ = false;
+    sqArray_[index] = index;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+
+    blockOffsets_[current_] = offset_;
+    blockLengths_[current_] = length;
+    offset_ += fill_;
+    fill_ = 0;
+    unsubmitted_ = false;
+    ++inFlight_;
+    enter(1, 0);
+  }
+
+  inline void nextBlock()
+  {
+    reap();
+    while (freeBlocks_.empty())
+    {
+      enter(0, 1);
+      reap();
+    }
+    current_ = freeBlocks_.back();
+    freeBlocks_.pop_back();
+  }
+
+  inline void waitForWrites()
+  {
+    while (inFlight_ != 0)
+    {
+      enter(0, 1);
+      reap();
+    }
+  }
+
+  inline void enter(const unsigned toSubmit, const unsigned minComplete)
+  {
+    const unsigned flags = minComplete != 0 ? IORING_ENTER_GETEVENTS : 0u;
+    while (syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete, flags, nullptr,
+                   0) < 0 &&
+           errno == EINTR)
+    {}
+  }
+
+  // collects the completed writes, without a syscall
+  inline void reap()
+  {
+    unsigned head = *cqHead_;
+    const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+    {
+      const io_uring_cqe& cqe = cqes_[head & cqMask_];
+      const auto index = static_cast<unsigned>(cqe.user_data);
+      const auto written = cqe.res > 0 ? static_cast<std::size_t>(cqe.res) : 0u;
+      if (written < blockLengths_[index]) writeRemainder(index, written);
+      freeBlocks_.push_back(index);
+      --inFlight_;
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+  }
+
+  // short or failed asynchronous write: retry the rest synchronously. Writes are also
+  // cancelled by the kernel, when the thread which submitted them exits.
+  inline void writeRemainder(const unsigned index, std::size_t written)
+  {
+    while (written < blockLengths_[index])
+    {
+      const auto result = pwrite(fileFd_, block(index) + written,
+                                 blockLengths_[index] - written,
+                                 static_cast<off_t>(blockOffsets_[index] + written));
+      if (result < 0 && errno == EINTR) continue;
+      if (result <= 0) return;  // nothing sensible left to do for a logger
+      written += static_cast<std::size_t>(result);
+    }
+  }
+
+  const std::size_t blockSize_;
+  const unsigned blockCount_;
+  const std::chrono::milliseconds flushInterval_;
+  const int syncLevel_;  // log() waits for the writes from this level on
+  char* blocks_ = nullptr;
+  std::vector<unsigned> freeBlocks_;
+  std::vector<unsigned long long> blockOffsets_;
+  std::vector<std::size_t> blockLengths_;
+  unsigned current_ = 0;
+  std::size_t fill_ = 0;
+  unsigned long long offset_ = 0;
+  unsigned inFlight_ = 0;
+  bool unsubmitted_ = false;  // the current block holds messages not yet submitted
+  Clock::time_point unsubmittedSince_{};
+  bool drainNext_ = false;  // the next write overlaps the previous one
+
+  int ringFd_ = -1;
+  int fileFd_ = -1;
+  bool direct_ = false;
+  bool buffersRegistered_ = false;
+  char* sqRing_ = nullptr;
+  char* cqRing_ = nullptr;
+  io_uring_sqe* sqes_ = nullptr;
+  std::size_t sqRingSize_ = 0;
+  std::size_t cqRingSize_ = 0;
+  std::size_t sqesSize_ = 0;
+  unsigned* sqTail_ = nullptr;
+  unsigned* sqArray_ = nullptr;
+  unsigned sqMask_ = 0;
+  unsigned* cqHead_ = nullptr;
+  unsigned* cqTail_ = nullptr;
+  unsigned cqMask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+};
+
+}  // namespace bragi
+
+#endif  // BRAGI_HAS_IO_URING
+#endif  // _BRAGI_URING_LOG_WRITER_H_